@@ -0,0 +1,636 @@
+#include "msm.h"
+#include "ntt.h"
+#include "parallel.h"
+#include "profile.h"
+#include "kzg.h"
+#include "zerotest.h"
+#include "sumcheck.h"
+#include "multipoint.h"
+#include "arena.h"
+#include <mcl/bn.hpp>
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <chrono>
+#include <iomanip>
+#include <atomic>
+#include <new>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace std;
+using namespace mcl;
+using namespace bn;
+using namespace std::chrono;
+
+// Every operator new in the process is counted so benchProofMemory() can report
+// allocations and peak heap use. The size is kept in a 16-byte header to keep
+// the alignment malloc gives. Arena scratch bypasses this and is reported apart.
+static atomic<size_t> alloc_count(0), live_bytes(0), peak_bytes(0);
+
+static void *countedAlloc(size_t size) {
+    void *p = malloc(size + 16);
+    if (!p) return nullptr;
+    *(size_t *)p = size;
+
+    alloc_count++;
+    size_t live = live_bytes += size;
+    size_t peak = peak_bytes.load();
+    while (live > peak && !peak_bytes.compare_exchange_weak(peak, live)) {}
+    return (char *)p + 16;
+}
+
+static void countedFree(void *p) {
+    if (!p) return;
+    p = (char *)p - 16;
+    live_bytes -= *(size_t *)p;
+    free(p);
+}
+
+void *operator new(size_t size) {
+    void *p = countedAlloc(size);
+    if (!p) throw bad_alloc();
+    return p;
+}
+void *operator new[](size_t size) { return operator new(size); }
+void *operator new(size_t size, const nothrow_t &) noexcept { return countedAlloc(size); }
+void *operator new[](size_t size, const nothrow_t &) noexcept { return countedAlloc(size); }
+void operator delete(void *p) noexcept { countedFree(p); }
+void operator delete[](void *p) noexcept { countedFree(p); }
+void operator delete(void *p, const nothrow_t &) noexcept { countedFree(p); }
+void operator delete[](void *p, const nothrow_t &) noexcept { countedFree(p); }
+
+double elapsedSeconds(high_resolution_clock::time_point start_time) {
+    auto end_time = high_resolution_clock::now();
+    return duration_cast<microseconds>(end_time - start_time).count() / 1e6;
+}
+
+// Compares the Pippenger MSM against the per-term mul/add loop it replaced
+void benchMSM(size_t min_log, size_t max_log) {
+    cout << "=== MSM: Pippenger vs naive (threads: " << getThreadCount() << ") ===" << endl;
+    cout << setw(8) << "log n" << setw(14) << "naive (s)" << setw(14) << "msm (s)" << setw(12) << "speedup" << endl;
+
+    vector<G1> bases(1 << max_log);
+    vector<Fr> scalars(1 << max_log);
+    G1 g;
+    hashAndMapToG1(g, "bench", 5);
+    for (size_t i = 0; i < bases.size(); i++) {
+        Fr r;
+        r.setByCSPRNG();
+        G1::mul(bases[i], g, r);
+        scalars[i].setByCSPRNG();
+    }
+
+    for (size_t log_n = min_log; log_n <= max_log; log_n++) {
+        size_t n = 1 << log_n;
+        G1 naive, fast;
+
+        auto start_time = high_resolution_clock::now();
+        msmG1Naive(naive, bases.data(), scalars.data(), n);
+        double naive_time = elapsedSeconds(start_time);
+
+        start_time = high_resolution_clock::now();
+        msmG1(fast, bases.data(), scalars.data(), n);
+        double msm_time = elapsedSeconds(start_time);
+
+        if (naive != fast) cout << "✗ MSM mismatch at log n = " << log_n << endl;
+
+        cout << setw(8) << log_n << setw(14) << fixed << setprecision(4) << naive_time
+             << setw(14) << msm_time << setw(11) << setprecision(2) << naive_time / msm_time << "x" << endl;
+    }
+    cout << endl;
+}
+
+// Forward NTT time at a fixed size for 1, 2, 4, ... up to the hardware thread count
+void benchNTTScaling(size_t log_n) {
+    size_t n = 1 << log_n;
+    size_t max_threads = getThreadCount();
+    cout << "=== NTT thread scaling (log n = " << log_n << ") ===" << endl;
+    cout << setw(8) << "threads" << setw(14) << "ntt (s)" << setw(12) << "speedup" << endl;
+
+    const EvaluationDomain &domain = EvaluationDomain::get(log_n);
+    vector<Fr> input(n);
+    for (auto &x : input) x.setByCSPRNG();
+
+    vector<size_t> thread_counts;
+    for (size_t threads = 1; threads < max_threads; threads *= 2) thread_counts.push_back(threads);
+    thread_counts.push_back(max_threads);
+
+    vector<Fr> reference;
+    double base_time = 0;
+    for (size_t threads : thread_counts) {
+        setThreadCount(threads);
+        vector<Fr> A = input;
+
+        auto start_time = high_resolution_clock::now();
+        domain.ntt(A);
+        double ntt_time = elapsedSeconds(start_time);
+
+        if (threads == 1) {
+            base_time = ntt_time;
+            reference = A;
+        } else if (A != reference) {
+            cout << "✗ NTT result differs with " << threads << " threads" << endl;
+        }
+
+        cout << setw(8) << threads << setw(14) << fixed << setprecision(4) << ntt_time
+             << setw(11) << setprecision(2) << base_time / ntt_time << "x" << endl;
+    }
+    setThreadCount(0);
+    cout << endl;
+}
+
+// Single-threaded forward NTT time per butterfly kernel the CPU supports,
+// with the speedup over the generic kernel
+void benchNTTKernels(size_t min_log, size_t max_log) {
+    cout << "=== NTT butterfly kernels (threads: 1, auto: " << nttKernelName() << ") ===" << endl;
+    cout << setw(8) << "log n" << setw(14) << "kernel" << setw(14) << "time (s)" << setw(12) << "speedup" << endl;
+
+    setThreadCount(1);
+    for (size_t log_n = min_log; log_n <= max_log; log_n++) {
+        const EvaluationDomain &domain = EvaluationDomain::get(log_n);
+        vector<Fr> input(domain.size);
+        for (auto &x : input) x.setByCSPRNG();
+
+        vector<Fr> reference;
+        double generic_time = 0;
+        for (NttKernel kernel : {NttKernel::Generic, NttKernel::Unrolled, NttKernel::Avx2, NttKernel::Avx512Ifma}) {
+            if (!nttKernelSupported(kernel)) continue;
+            setNttKernel(kernel);
+
+            vector<Fr> output = input;
+            auto start_time = high_resolution_clock::now();
+            domain.ntt(output);
+            double time = elapsedSeconds(start_time);
+
+            if (kernel == NttKernel::Generic) {
+                reference = output;
+                generic_time = time;
+            } else if (output != reference) {
+                cout << "✗ Kernel mismatch at log n = " << log_n << endl;
+            }
+
+            cout << setw(8) << log_n << setw(14) << nttKernelName() << setw(14) << fixed << setprecision(4) << time
+                 << setw(11) << setprecision(2) << generic_time / time << "x" << endl;
+        }
+    }
+    setNttKernel(NttKernel::Auto);
+    setThreadCount(0);
+    cout << endl;
+}
+
+// Throughput in polynomials per second for one NTT per call, the batch API and the interleaved layout
+void benchNTTBatch(size_t log_n, size_t count) {
+    size_t n = 1 << log_n;
+    Fr omega = findPrimitiveRoot(n);
+    cout << "=== Batched NTT (" << count << " polynomials, log n = " << log_n << ") ===" << endl;
+    cout << setw(14) << "mode" << setw(14) << "time (s)" << setw(14) << "polys/s" << endl;
+
+    vector<vector<Fr>> polys(count, vector<Fr>(n));
+    for (auto &p : polys) {
+        for (auto &x : p) x.setByCSPRNG();
+    }
+    vector<Fr> interleaved(count * n);
+    for (size_t i = 0; i < n; i++) {
+        for (size_t p = 0; p < count; p++) interleaved[i * count + p] = polys[p][i];
+    }
+
+    vector<vector<Fr>> single = polys;
+    auto start_time = high_resolution_clock::now();
+    for (auto &p : single) ntt_transform(p, omega);
+    double single_time = elapsedSeconds(start_time);
+
+    start_time = high_resolution_clock::now();
+    ntt_transform_batch(polys, omega);
+    double batch_time = elapsedSeconds(start_time);
+
+    start_time = high_resolution_clock::now();
+    ntt_transform_interleaved(interleaved, count, omega);
+    double interleaved_time = elapsedSeconds(start_time);
+
+    if (single != polys || interleaved[n / 2 * count] != single[0][n / 2]) cout << "✗ Batched NTT mismatch" << endl;
+
+    cout << setw(14) << "single" << setw(14) << fixed << setprecision(4) << single_time << setw(14) << setprecision(1) << count / single_time << endl;
+    cout << setw(14) << "batch" << setw(14) << setprecision(4) << batch_time << setw(14) << setprecision(1) << count / batch_time << endl;
+    cout << setw(14) << "interleaved" << setw(14) << setprecision(4) << interleaved_time << setw(14) << setprecision(1) << count / interleaved_time << endl;
+    cout << endl;
+}
+
+// Openings verified per second, one verifyEval() each vs a single verifyEvalBatch()
+void benchVerify(size_t degree, size_t count) {
+    cout << "=== KZG verification (" << count << " openings, degree " << degree << ") ===" << endl;
+    cout << setw(14) << "mode" << setw(14) << "time (s)" << setw(14) << "openings/s" << endl;
+
+    KZG::PublicKey pk = setup(degree, false);
+    vector<Fr> poly(degree + 1);
+    for (auto &c : poly) c.setByCSPRNG();
+    KZG::Commitment comm = commit(pk, poly);
+
+    vector<KZG::Commitment> comms(count, comm);
+    vector<KZG::Witness> witnesses(count);
+    for (auto &w : witnesses) {
+        Fr point;
+        point.setByCSPRNG();
+        w = createWitness(pk, poly, point);
+    }
+
+    auto start_time = high_resolution_clock::now();
+    bool single_ok = true;
+    for (size_t k = 0; k < count; k++) single_ok &= verifyEval(pk, comms[k], witnesses[k].i, witnesses[k]);
+    double single_time = elapsedSeconds(start_time);
+
+    start_time = high_resolution_clock::now();
+    bool batch_ok = verifyEvalBatch(pk, comms, witnesses);
+    double batch_time = elapsedSeconds(start_time);
+
+    if (!single_ok || !batch_ok) cout << "✗ Verification failed" << endl;
+
+    cout << setw(14) << "single" << setw(14) << fixed << setprecision(4) << single_time << setw(14) << setprecision(1) << count / single_time << endl;
+    cout << setw(14) << "batch" << setw(14) << setprecision(4) << batch_time << setw(14) << setprecision(1) << count / batch_time << endl;
+    cout << endl;
+}
+
+// k polynomials of size n vanishing on H of size n/2: k ZeroTest proofs vs one batched proof
+void benchZeroTestBatch(size_t log_n, size_t max_k) {
+    size_t n = (size_t)1 << log_n, l = n / 2;
+    cout << "=== ZeroTest over k polynomials (n = 2^" << log_n << ") ===" << endl;
+    cout << setw(6) << "k" << setw(16) << "prove k (s)" << setw(16) << "verify k (s)" << setw(16) << "prove batch (s)"
+         << setw(18) << "verify batch (s)" << endl;
+
+    KZG::PublicKey pk = setup(n, false);
+    Fr w = findPrimitiveRoot(l);
+
+    for (size_t k = 1; k <= max_k; k *= 4) {
+        // q = g * (x^l - 1) vanishes on H
+        vector<vector<Fr>> polys(k, vector<Fr>(n, 0));
+        for (auto &q : polys) {
+            for (size_t j = 0; j + l < n; j++) {
+                Fr c;
+                c.setByCSPRNG();
+                q[j] -= c;
+                q[j + l] += c;
+            }
+        }
+        vector<PolyView> views(polys.begin(), polys.end());
+
+        auto start_time = high_resolution_clock::now();
+        vector<ZeroTestProof> proofs;
+        vector<KZG::Commitment> comms;
+        for (const auto &q : polys) {
+            comms.push_back(commit(pk, q));
+            proofs.push_back(proveZeroTest(pk, q, comms.back(), w, l));
+        }
+        double prove_time = elapsedSeconds(start_time);
+
+        start_time = high_resolution_clock::now();
+        bool single_ok = true;
+        for (size_t k = 0; k < proofs.size(); k++) single_ok &= verifyZeroTest(pk, comms[k], proofs[k], l);
+        double verify_time = elapsedSeconds(start_time);
+
+        // Both prover columns include committing to the q_k
+        start_time = high_resolution_clock::now();
+        vector<KZG::Commitment> batch_comms;
+        for (const auto &q : polys) batch_comms.push_back(commit(pk, q));
+        ZeroTestBatchProof batch = proveZeroTestBatch(pk, views, batch_comms, w, l);
+        double batch_prove_time = elapsedSeconds(start_time);
+
+        start_time = high_resolution_clock::now();
+        bool batch_ok = verifyZeroTestBatch(pk, comms, batch, l);
+        double batch_verify_time = elapsedSeconds(start_time);
+
+        if (!single_ok || !batch_ok) cout << "✗ Verification failed" << endl;
+
+        cout << setw(6) << k << fixed << setprecision(5) << setw(16) << prove_time << setw(16) << verify_time
+             << setw(16) << batch_prove_time << setw(18) << batch_verify_time << endl;
+    }
+    cout << endl;
+}
+
+// n points of a degree n-1 polynomial: Horner per point vs a subproduct tree, built once and then reused
+void benchMultipoint(size_t min_log, size_t max_log) {
+    cout << "=== Multipoint evaluation at arbitrary points ===" << endl;
+    cout << setw(8) << "log n" << setw(14) << "horner (s)" << setw(14) << "build (s)" << setw(14) << "tree (s)" << setw(12) << "speedup" << endl;
+
+    for (size_t log_n = min_log; log_n <= max_log; log_n++) {
+        size_t n = 1 << log_n;
+        vector<Fr> points(n), poly(n);
+        for (auto &x : points) x.setByCSPRNG();
+        for (auto &x : poly) x.setByCSPRNG();
+
+        auto start_time = high_resolution_clock::now();
+        vector<Fr> horner(n);
+        for (size_t j = 0; j < n; j++) horner[j] = evaluatePoly(poly, points[j]);
+        double horner_time = elapsedSeconds(start_time);
+
+        start_time = high_resolution_clock::now();
+        SubproductTree tree(points);
+        tree.evaluate(poly); // First query extends the cached inverses
+        double build_time = elapsedSeconds(start_time);
+
+        start_time = high_resolution_clock::now();
+        vector<Fr> fast = tree.evaluate(poly);
+        double tree_time = elapsedSeconds(start_time);
+
+        if (fast != horner) cout << "✗ Multipoint mismatch at log n = " << log_n << endl;
+
+        cout << setw(8) << log_n << setw(14) << fixed << setprecision(4) << horner_time << setw(14) << build_time
+             << setw(14) << tree_time << setw(11) << setprecision(2) << horner_time / tree_time << "x" << endl;
+    }
+    cout << endl;
+}
+
+// Allocations and peak heap growth of one prove + verify, against the size of the SRS
+void benchProofMemory(size_t log_n) {
+    size_t l = 1 << log_n, degree = 4 * l;
+    cout << "=== Proof memory (l = " << l << ", degree " << degree << ") ===" << endl;
+    cout << setw(14) << "protocol" << setw(14) << "allocs" << setw(16) << "peak (KiB)" << setw(16) << "arena (KiB)"
+         << setw(16) << "SRS (KiB)" << endl;
+
+    KZG::PublicKey pk = setup(degree, false);
+    double srs_kib = (pk.g1.size() * sizeof(G1) + pk.g2.size() * sizeof(G2)) / 1024.0;
+    Fr w = findPrimitiveRoot(l);
+
+    // q = g * (x^l - 1) vanishes on H, and q + s/l sums to s over H
+    vector<Fr> q(degree + 1, 0);
+    for (size_t j = 0; j + l <= degree; j++) {
+        Fr c;
+        c.setByCSPRNG();
+        q[j] -= c;
+        q[j + l] += c;
+    }
+    Fr s = 12345;
+    vector<Fr> q_sum = q;
+    q_sum[0] += s / l;
+
+    for (int protocol = 0; protocol < 2; protocol++) {
+        size_t base_count = alloc_count.load(), base_live = live_bytes.load();
+        peak_bytes.store(base_live);
+
+        // Prover scratch comes from the thread arena, which operator new never
+        // sees. Each proof runs on a fresh thread so its arena starts empty, and
+        // the arena keeps its blocks, so its capacity is what the proof mapped at
+        // its high-water mark, rounded up to whole blocks.
+        bool ok = false;
+        size_t arena_bytes = 0;
+        thread prover([&] {
+            if (protocol == 0) {
+                KZG::Commitment comm_q = commit(pk, q);
+                ok = verifyZeroTest(pk, comm_q, proveZeroTest(pk, q, comm_q, w, l), l);
+            } else {
+                KZG::Commitment comm_q = commit(pk, q_sum);
+                ok = verifySumCheck(pk, comm_q, proveSumCheck(pk, q_sum, comm_q, l, s), l, s);
+            }
+            arena_bytes = threadArena().capacity();
+        });
+        prover.join();
+        if (!ok) cout << "✗ Proof failed" << endl;
+
+        cout << setw(14) << (protocol == 0 ? "ZeroTest" : "SumCheck") << setw(14) << alloc_count.load() - base_count
+             << setw(16) << fixed << setprecision(1) << (peak_bytes.load() - base_live) / 1024.0 << setw(16)
+             << arena_bytes / 1024.0 << setw(16) << srs_kib << endl;
+    }
+    cout << endl;
+}
+
+// Summary of the repeated timings of one operation at one size and thread count
+struct BenchResult {
+    string op;
+    size_t log_n;
+    size_t threads;
+    vector<double> samples; // Seconds per repetition
+
+    double min() const { return *min_element(samples.begin(), samples.end()); }
+    double max() const { return *max_element(samples.begin(), samples.end()); }
+
+    double median() const {
+        vector<double> sorted = samples;
+        sort(sorted.begin(), sorted.end());
+        size_t n = sorted.size();
+        return n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+    }
+
+    double mean() const {
+        double sum = 0;
+        for (double x : samples) sum += x;
+        return sum / samples.size();
+    }
+
+    double stddev() const {
+        if (samples.size() < 2) return 0;
+        double m = mean(), sum = 0;
+        for (double x : samples) sum += (x - m) * (x - m);
+        return sqrt(sum / (samples.size() - 1));
+    }
+};
+
+struct SuiteConfig {
+    size_t min_log = 10;
+    size_t max_log = 24;
+    size_t step = 2;
+    size_t warmup = 1;
+    size_t reps = 5;
+    vector<size_t> threads = {0}; // 0 is the hardware concurrency
+    vector<string> only; // Operations to run, empty for all
+    string json_path;
+    string csv_path;
+    string trace_path; // Chrome trace of the whole sweep, needs a PROFILE=1 build
+};
+
+static vector<string> splitList(const string &list) {
+    vector<string> items;
+    stringstream stream(list);
+    string item;
+    while (getline(stream, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+// Runs fn warmup times unmeasured, then reps measured times
+static vector<double> measure(const function<void()> &fn, size_t warmup, size_t reps) {
+    for (size_t r = 0; r < warmup; r++) fn();
+
+    vector<double> samples;
+    for (size_t r = 0; r < reps; r++) {
+        auto start_time = high_resolution_clock::now();
+        fn();
+        samples.push_back(duration_cast<nanoseconds>(high_resolution_clock::now() - start_time).count() / 1e9);
+    }
+    return samples;
+}
+
+static void writeJSON(const string &path, const SuiteConfig &config, const vector<BenchResult> &results) {
+    ofstream out(path);
+    if (!out) throw runtime_error("Cannot write " + path);
+
+    out << "{\n  \"hardware_threads\": " << thread::hardware_concurrency()
+        << ",\n  \"warmup\": " << config.warmup << ",\n  \"reps\": " << config.reps << ",\n  \"results\": [\n";
+    out << setprecision(9) << scientific;
+    for (size_t k = 0; k < results.size(); k++) {
+        const BenchResult &r = results[k];
+        out << "    {\"op\": \"" << r.op << "\", \"log_n\": " << r.log_n << ", \"threads\": " << r.threads
+            << ", \"reps\": " << r.samples.size() << ", \"min_s\": " << r.min() << ", \"median_s\": " << r.median()
+            << ", \"mean_s\": " << r.mean() << ", \"stddev_s\": " << r.stddev() << ", \"max_s\": " << r.max() << "}"
+            << (k + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+static void writeCSV(const string &path, const vector<BenchResult> &results) {
+    ofstream out(path);
+    if (!out) throw runtime_error("Cannot write " + path);
+
+    out << "op,log_n,threads,reps,min_s,median_s,mean_s,stddev_s,max_s\n";
+    out << setprecision(9) << scientific;
+    for (const auto &r : results) {
+        out << r.op << "," << r.log_n << "," << r.threads << "," << r.samples.size() << "," << r.min() << ","
+            << r.median() << "," << r.mean() << "," << r.stddev() << "," << r.max() << "\n";
+    }
+}
+
+// Sweeps every operation over the configured sizes and thread counts
+void benchSuite(const SuiteConfig &config) {
+    cout << "=== Benchmark suite (log n " << config.min_log << ".." << config.max_log << ", warmup " << config.warmup
+         << ", reps " << config.reps << ") ===" << endl;
+    cout << setw(16) << "op" << setw(8) << "log n" << setw(9) << "threads" << setw(14) << "median (s)"
+         << setw(14) << "min (s)" << setw(14) << "stddev (s)" << endl;
+
+    vector<BenchResult> results;
+    profileReset();
+    for (size_t threads : config.threads) {
+        setThreadCount(threads);
+
+        for (size_t log_n = config.min_log; log_n <= config.max_log; log_n += config.step) {
+            size_t n = (size_t)1 << log_n, l = n / 2;
+            Fr omega = findPrimitiveRoot(n);
+
+            vector<Fr> poly(n), other(n);
+            for (auto &x : poly) x.setByCSPRNG();
+            for (auto &x : other) x.setByCSPRNG();
+            Fr point;
+            point.setByCSPRNG();
+
+            // q = g * (x^l - 1) vanishes on H of size l, q + s/l sums to s over H
+            vector<Fr> q(n, 0);
+            for (size_t j = 0; j + l < n; j++) {
+                q[j] -= other[j];
+                q[j + l] += other[j];
+            }
+            Fr s = 12345;
+            vector<Fr> q_sum = q;
+            q_sum[0] += s / l;
+            Fr w = findPrimitiveRoot(l);
+
+            KZG::PublicKey pk;
+            KZG::Commitment comm;
+            KZG::Witness witness;
+
+            vector<pair<string, function<void()>>> ops = {
+                {"ntt", [&] { ntt_transform(poly, omega); }},
+                {"intt", [&] { ntt_inverse(poly, omega); }},
+                {"poly_multiply", [&] {
+                    vector<Fr> half(poly.begin(), poly.begin() + n / 2), rest(other.begin(), other.begin() + n / 2);
+                    polynomial_multiply(half, rest, omega);
+                }},
+                {"setup", [&] { pk = setup(n, false); }},
+                {"commit", [&] { comm = commit(pk, poly); }},
+                {"create_witness", [&] { witness = createWitness(pk, poly, point); }},
+                {"verify_eval", [&] { verifyEval(pk, comm, point, witness); }},
+                {"zerotest", [&] {
+                    KZG::Commitment comm_q = commit(pk, q);
+                    verifyZeroTest(pk, comm_q, proveZeroTest(pk, q, comm_q, w, l), l);
+                }},
+                {"sumcheck", [&] {
+                    KZG::Commitment comm_q = commit(pk, q_sum);
+                    verifySumCheck(pk, comm_q, proveSumCheck(pk, q_sum, comm_q, l, s), l, s);
+                }}
+            };
+
+            auto selected = [&config](const string &name) {
+                return config.only.empty() || find(config.only.begin(), config.only.end(), name) != config.only.end();
+            };
+            // Every operation after setup needs a key
+            bool needs_key = false;
+            for (size_t k = 4; k < ops.size(); k++) needs_key = needs_key || selected(ops[k].first);
+            if (needs_key && !selected("setup")) pk = setup(n, false);
+
+            for (auto &op : ops) {
+                if (!selected(op.first)) continue;
+                if (op.first == "verify_eval") {
+                    comm = commit(pk, poly);
+                    witness = createWitness(pk, poly, point);
+                }
+
+                BenchResult result;
+                result.op = op.first;
+                result.log_n = log_n;
+                result.threads = getThreadCount();
+                result.samples = measure(op.second, config.warmup, config.reps);
+                results.push_back(result);
+
+                cout << setw(16) << result.op << setw(8) << log_n << setw(9) << result.threads << setw(14) << scientific
+                     << setprecision(3) << result.median() << setw(14) << result.min() << setw(14) << result.stddev() << endl;
+            }
+        }
+    }
+    setThreadCount(0);
+    cout << fixed << endl;
+
+    if (!config.json_path.empty()) writeJSON(config.json_path, config, results);
+    if (!config.csv_path.empty()) writeCSV(config.csv_path, results);
+
+    if (!config.trace_path.empty()) {
+        if (!profileEnabled()) cerr << "Built without KZG_PROFILE, the trace is empty." << endl;
+        writeChromeTrace(config.trace_path);
+        printProfileSummary(cout, profileSummary());
+    }
+}
+
+int main(int argc, char **argv) {
+    initPairing(BN_SNARK1);
+
+    // bench [max_log] runs the comparisons below, bench --suite [options] the full sweep
+    if (argc > 1 && strcmp(argv[1], "--suite") == 0) {
+        SuiteConfig config;
+        for (int k = 2; k + 1 < argc; k += 2) {
+            string option = argv[k], value = argv[k + 1];
+            if (option == "--min-log") config.min_log = atoi(value.c_str());
+            else if (option == "--max-log") config.max_log = atoi(value.c_str());
+            else if (option == "--step") config.step = max(1, atoi(value.c_str()));
+            else if (option == "--warmup") config.warmup = atoi(value.c_str());
+            else if (option == "--reps") config.reps = max(1, atoi(value.c_str()));
+            else if (option == "--only") config.only = splitList(value);
+            else if (option == "--json") config.json_path = value;
+            else if (option == "--csv") config.csv_path = value;
+            else if (option == "--trace") config.trace_path = value;
+            else if (option == "--threads") {
+                config.threads.clear();
+                for (const auto &t : splitList(value)) config.threads.push_back(atoi(t.c_str()));
+            } else {
+                cerr << "Unknown option " << option << endl;
+                return 1;
+            }
+        }
+        benchSuite(config);
+        return 0;
+    }
+
+    size_t max_log = argc > 1 ? atoi(argv[1]) : 16;
+
+    benchMSM(10, max_log);
+    benchNTTKernels(10, max_log + 4);
+    benchNTTScaling(max_log + 4);
+    benchNTTBatch(max_log, 32);
+    benchVerify(64, 1024);
+    benchProofMemory(max_log - 4);
+    benchMultipoint(10, max_log - 2);
+    benchZeroTestBatch(max_log - 4, 64);
+
+    return 0;
+}
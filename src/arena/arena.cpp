@@ -0,0 +1,88 @@
+#include "arena.h"
+#include <mcl/bn.hpp>
+#include <algorithm>
+#include <new>
+#include <sys/mman.h>
+
+using namespace std;
+using namespace mcl;
+using namespace bn;
+
+static const size_t HUGE_PAGE = 2 << 20;
+
+// Maps size bytes, huge pages first, then regular pages with a transparent huge page hint
+static void *mapBlock(size_t size, bool &huge) {
+    void *p = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+    huge = p != MAP_FAILED;
+    if (huge) return p;
+
+    p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) throw bad_alloc();
+#ifdef MADV_HUGEPAGE
+    madvise(p, size, MADV_HUGEPAGE);
+#endif
+    return p;
+}
+
+Arena::Arena(size_t block_bytes) : current(0), offset(0), block_bytes(block_bytes) {}
+
+Arena::~Arena() {
+    for (auto &b : blocks) munmap(b.data, b.size);
+}
+
+void *Arena::allocate(size_t bytes, size_t align) {
+    if (current < blocks.size()) {
+        size_t start = (offset + align - 1) / align * align;
+        if (start + bytes <= blocks[current].size) {
+            offset = start + bytes;
+            return blocks[current].data + start;
+        }
+    }
+
+    // Move on to the next block, mapping a new one if the next is missing or
+    // too small. Blocks are page aligned, so offset 0 satisfies any align.
+    size_t next = blocks.empty() ? 0 : current + 1;
+    if (next >= blocks.size() || blocks[next].size < bytes) {
+        Block b;
+        b.size = (max(block_bytes, bytes) + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE;
+        b.data = (uint8_t *)mapBlock(b.size, b.huge);
+        blocks.insert(blocks.begin() + next, b);
+    }
+
+    current = next;
+    offset = bytes;
+    return blocks[current].data;
+}
+
+Fr *Arena::allocFr(size_t n) {
+    Fr *p = (Fr *)allocate(n * sizeof(Fr), max((size_t)64, alignof(Fr)));
+    for (size_t j = 0; j < n; j++) new (p + j) Fr(0);
+    return p;
+}
+
+void Arena::rewind(const Mark &m) {
+    current = m.block;
+    offset = m.offset;
+}
+
+size_t Arena::capacity() const {
+    size_t total = 0;
+    for (const auto &b : blocks) total += b.size;
+    return total;
+}
+
+size_t Arena::hugeCapacity() const {
+    size_t total = 0;
+    for (const auto &b : blocks) {
+        if (b.huge) total += b.size;
+    }
+    return total;
+}
+
+Arena &threadArena() {
+    static thread_local Arena arena;
+    return arena;
+}
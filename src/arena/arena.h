@@ -0,0 +1,94 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <mcl/bn.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace mcl;
+using namespace bn;
+using namespace std;
+
+/**
+ * @brief Bump allocator for short-lived field-element buffers
+ *
+ * Memory is taken from the OS in large blocks, backed by huge pages when the
+ * system allows it, and handed out by bumping an offset. Nothing is freed per
+ * buffer: rewind() drops everything allocated after a mark and keeps the
+ * blocks for reuse, so a prover that runs in a loop stops allocating once the
+ * arena has grown to its working set.
+ */
+class Arena {
+public:
+    struct Mark {
+        size_t block;
+        size_t offset;
+    };
+
+    /**
+     * @brief Creates an empty arena, no memory is mapped until the first allocation
+     * @param block_bytes Minimum size of each block taken from the OS
+     */
+    explicit Arena(size_t block_bytes = 32 << 20);
+    ~Arena();
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    void *allocate(size_t bytes, size_t align = 64);
+
+    // n zero-initialized field elements
+    Fr *allocFr(size_t n);
+
+    Mark mark() const { return Mark{current, offset}; }
+    void rewind(const Mark &m);
+    void reset() { rewind(Mark{0, 0}); }
+
+    // Bytes mapped from the OS, and how many of them are huge-page backed
+    size_t capacity() const;
+    size_t hugeCapacity() const;
+
+private:
+    struct Block {
+        uint8_t *data;
+        size_t size;
+        bool huge;
+    };
+
+    vector<Block> blocks;
+    size_t current;
+    size_t offset;
+    size_t block_bytes;
+};
+
+/**
+ * @brief Returns the arena of the calling thread
+ *
+ * Prover code takes its scratch buffers from here through ArenaScope, so
+ * concurrent proofs on different threads never share an arena.
+ */
+Arena &threadArena();
+
+/**
+ * @brief Releases everything allocated from an arena during its lifetime
+ *
+ * Scopes nest: an inner scope rewinds only to where it started, so buffers of
+ * the enclosing scope stay valid.
+ */
+class ArenaScope {
+public:
+    explicit ArenaScope(Arena &arena = threadArena()) : arena(arena), start(arena.mark()) {}
+    ~ArenaScope() { arena.rewind(start); }
+
+    ArenaScope(const ArenaScope &) = delete;
+    ArenaScope &operator=(const ArenaScope &) = delete;
+
+    Fr *allocFr(size_t n) { return arena.allocFr(n); }
+
+private:
+    Arena &arena;
+    Arena::Mark start;
+};
+
+#endif // ARENA_H
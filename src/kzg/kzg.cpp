@@ -1,16 +1,25 @@
 #include "kzg.h"
+#include "../msm/msm.h"
+#include "../parallel/parallel.h"
+#include "../ntt/ntt.h"
+#include "../arena/arena.h"
+#include "../profile/profile.h"
 #include <mcl/bn.hpp>
 #include <mcl/lagrange.hpp>
+#include <algorithm>
+#include <stdexcept>
 
 using namespace std;
 using namespace mcl;
 using namespace bn;
 
-KZG::PublicKey setup(size_t t) {
+KZG::PublicKey setup(size_t t, bool g2_powers) {
+    PROFILE_SPAN("setup");
     KZG::PublicKey pk;
     pk.t = t;
     pk.g1.resize(t+1);
-    pk.g2.resize(t+1);
+    // verifyEval() only reads g^1 and g^a in G2
+    pk.g2.resize(g2_powers ? t+1 : min(t+1, (size_t)2));
 
     Fr a;
     a.setByCSPRNG();
@@ -21,86 +30,520 @@ KZG::PublicKey setup(size_t t) {
     G2 g2;
     hashAndMapToG2(g2, "G2_Generator", strlen("G2_Generator"));
 
-    Fr power = 1;
-    for (size_t i = 0; i <= t; i++) {
-        G1::mul(pk.g1[i], g1, power);
-        G2::mul(pk.g2[i], g2, power);
-        Fr::mul(power, power, a);
-    }
+    // Each chunk starts from a^begin so the powers can be filled in parallel
+    vector<Fr> powers(t+1);
+    parallelFor(t+1, [&](size_t begin, size_t end, size_t) {
+        Fr power;
+        Fr::pow(power, a, begin);
+        for (size_t i = begin; i < end; i++) {
+            powers[i] = power;
+            Fr::mul(power, power, a);
+        }
+    }, 0, 1024);
 
+    fixedBaseMulG1(pk.g1.data(), g1, powers.data(), pk.g1.size());
+    fixedBaseMulG2(pk.g2.data(), g2, powers.data(), pk.g2.size());
+
+    prepareVerifier(pk);
     return pk;
 }
 
-KZG::Commitment commit(KZG::PublicKey pk, vector<Fr> q) {
-    KZG::Commitment comm; 
-    comm.c.clear(); 
+void prepareVerifier(KZG::PublicKey &pk) {
+    if (pk.g2.size() < 2) return;
+    precomputeG2(pk.g2_lines, pk.g2[0]);
+    precomputeG2(pk.g2a_lines, pk.g2[1]);
+}
+
+// e(P0, g) * e(P1, g^a) == 1 with one shared final exponentiation
+static bool pairingCheck(const KZG::PublicKey &pk, const G1 &P0, const G1 &P1) {
+    PROFILE_COUNT(MillerLoop, 2);
+    PROFILE_COUNT(FinalExp, 1);
 
-    for (size_t i = 0; i < q.size(); i++) {
-        G1 temp;
-        G1::mul(temp, pk.g1[i], q[i]);
-        G1::add(comm.c, comm.c, temp);
+    GT e;
+    if (!pk.g2_lines.empty()) {
+        precomputedMillerLoop2(e, P0, pk.g2_lines, P1, pk.g2a_lines);
+    } else {
+        G1 P[2] = {P0, P1};
+        G2 Q[2] = {pk.g2[0], pk.g2[1]};
+        millerLoopVec(e, P, Q, 2);
     }
+    finalExp(e, e);
+    return e.isOne();
+}
+
+KZG::SRSHandle shareKey(KZG::PublicKey &&pk) {
+    return make_shared<const KZG::PublicKey>(move(pk));
+}
+
+KZG::Commitment commit(const KZG::PublicKey &pk, PolyView q) {
+    PROFILE_SPAN("commit");
+    if (q.size > pk.g1.size()) throw runtime_error("Polynomial degree exceeds the SRS degree.");
+
+    KZG::Commitment comm; 
+    msmG1(comm.c, pk.g1.data(), q.data, q.size);
 
     return comm;
 }
 
 // Evaluate the value of q(i)
-Fr evaluatePoly(vector<Fr> q, Fr i) {
+Fr evaluatePoly(PolyView q, const Fr &i) {
     if (q.empty()) return Fr(0);
     
     Fr result;
-    evaluatePolynomial(result, q.data(), q.size(), i);
+    evaluatePolynomial(result, q.data, q.size, i);
     return result;
 }
 
-vector<Fr> divideByLinear(vector<Fr> q, Fr i) {
-    vector<Fr> result(q.size() - 1);
+// Below this many coefficients divideByLinear() runs serially
+static const size_t DIVIDE_PARALLEL_THRESHOLD = 1 << 14;
 
-    // Synthetic division from highest degree down
+// Synthetic division of q[lo, hi) alone, writes the partial quotients and
+// returns the carry out of the block, sum_{t in [lo, hi)} q[t] i^(t - lo)
+static Fr divideBlock(PolyView q, const Fr &i, Fr *quotient, size_t lo, size_t hi) {
     Fr carry = 0;
-    for (int j = q.size() - 1; j >= 1; --j) {
+    for (size_t j = hi; j-- > lo;) {
         carry = carry * i + q[j];
-        result[j - 1] = carry;
+        if (j >= 1) quotient[j - 1] = carry;
     }
+    return carry;
+}
+
+Fr divideByLinear(PolyView q, const Fr &i, Fr *quotient) {
+    if (q.empty()) return Fr(0);
+
+    size_t n = q.size, blocks = getThreadCount();
+    if (n < DIVIDE_PARALLEL_THRESHOLD || blocks <= 1) return divideBlock(q, i, quotient, 0, n);
 
+    // Each block divides on its own, then the true carry of coefficient j is
+    // its block-local carry plus i^(hi - j) times the carry into the block
+    vector<Fr> local(blocks), carry_in(blocks);
+    parallelFor(blocks, [&](size_t begin, size_t end, size_t) {
+        for (size_t b = begin; b < end; b++) local[b] = divideBlock(q, i, quotient, b * n / blocks, (b + 1) * n / blocks);
+    });
+
+    Fr carry = 0;
+    for (size_t b = blocks; b-- > 0;) {
+        carry_in[b] = carry;
+        Fr shift;
+        Fr::pow(shift, i, (b + 1) * n / blocks - b * n / blocks);
+        carry = local[b] + shift * carry;
+    }
+
+    parallelFor(blocks, [&](size_t begin, size_t end, size_t) {
+        for (size_t b = begin; b < end; b++) {
+            size_t lo = max(b * n / blocks, (size_t)1), hi = (b + 1) * n / blocks;
+            Fr power = i * carry_in[b];
+            for (size_t j = hi; j-- > lo;) {
+                quotient[j - 1] += power;
+                power *= i;
+            }
+        }
+    });
+
+    return carry;
+}
+
+vector<Fr> divideByLinear(PolyView q, const Fr &i) {
+    vector<Fr> result(q.empty() ? 0 : q.size - 1);
+    divideByLinear(q, i, result.data());
     return result;
 }
 
-KZG::Witness createWitness(KZG::PublicKey pk, vector<Fr> q, Fr i) {
+// Shared by createWitness() and the batch openings. The constant term does not
+// change the quotient, so (q - q(i)) / (x - i) comes out of one division.
+static KZG::Witness openAt(const KZG::PublicKey &pk, PolyView q, const Fr &i) {
     KZG::Witness witness;
     witness.i = i;
-    witness.w.clear();
+    if (q.size <= 1) {
+        witness.qi = evaluatePoly(q, i);
+        witness.w.clear();
+        return witness;
+    }
+
+    ArenaScope scratch;
+    Fr *quotient = scratch.allocFr(q.size - 1);
+    witness.qi = divideByLinear(q, i, quotient);
+
+    msmG1(witness.w, pk.g1.data(), quotient, q.size - 1);
+
+    return witness;
+}
+
+KZG::Witness createWitness(const KZG::PublicKey &pk, PolyView q, const Fr &i) {
+    PROFILE_SPAN("createWitness");
+    return openAt(pk, q, i);
+}
 
-    witness.qi = evaluatePoly(q, i);
+// e(C, g) == e(w, g^a / g^i) * e(g,g)^v rearranged so that v and i act in G1:
+// e(C - v g + i w, g) * e(-w, g^a) == 1, two Miller loops and no GT::pow
+static bool checkOpening(const KZG::PublicKey &pk, const G1 &c, const Fr &i, const G1 &w, const Fr &v) {
+    PROFILE_COUNT(G1Mul, 2);
 
-    q[0] -= witness.qi;
-    vector<Fr> result = divideByLinear(q, i);
+    G1 left, temp;
+    G1::mul(left, pk.g1[0], v);
+    G1::sub(left, c, left); // C - v g
+    G1::mul(temp, w, i);
+    G1::add(left, left, temp); // C - v g + i w
 
-    for (size_t j = 0; j < result.size(); j++) {
-        G1 temp;
-        G1::mul(temp, pk.g1[j], result[j]);
-        G1::add(witness.w, witness.w, temp);
+    G1 neg_w;
+    G1::neg(neg_w, w);
+    return pairingCheck(pk, left, neg_w);
+}
+
+bool verifyEval(const KZG::PublicKey &pk, const KZG::Commitment &comm, const Fr &i, const KZG::Witness &witness) {
+    PROFILE_SPAN("verifyEval");
+    return checkOpening(pk, comm.c, i, witness.w, witness.qi);
+}
+
+// Each opening holds iff e(C - v g + i w, g) == e(w, g^a). With random r_k the
+// product over k of these checks becomes e(A, g) * e(-B, g^a) == 1, where
+// A = sum r_k (C_k - v_k g + i_k w_k) and B = sum r_k w_k.
+static bool checkFolded(const KZG::PublicKey &pk, const vector<KZG::Commitment> &comms, const vector<KZG::Witness> &witnesses, const vector<size_t> &items) {
+    size_t m = items.size();
+    vector<G1> bases(2 * m + 1);
+    vector<Fr> scalars(2 * m + 1);
+    vector<Fr> r(m);
+    Fr v = 0;
+    for (size_t k = 0; k < m; k++) {
+        const KZG::Witness &witness = witnesses[items[k]];
+        r[k].setByCSPRNG();
+        bases[k] = comms[items[k]].c;
+        scalars[k] = r[k];
+        bases[m + k] = witness.w;
+        scalars[m + k] = r[k] * witness.i;
+        v += r[k] * witness.qi;
+    }
+    bases[2 * m] = pk.g1[0];
+    scalars[2 * m] = -v;
+
+    G1 P[2];
+    msmG1(P[0], bases.data(), scalars.data(), bases.size());
+    msmG1(P[1], bases.data() + m, r.data(), m);
+    G1::neg(P[1], P[1]);
+
+    return pairingCheck(pk, P[0], P[1]);
+}
+
+// Splits a rejected batch in halves until the failing openings are isolated
+static void findFailures(const KZG::PublicKey &pk, const vector<KZG::Commitment> &comms, const vector<KZG::Witness> &witnesses, const vector<size_t> &items, vector<size_t> &failed) {
+    if (checkFolded(pk, comms, witnesses, items)) return;
+    if (items.size() == 1) {
+        failed.push_back(items[0]);
+        return;
     }
 
+    size_t half = items.size() / 2;
+    findFailures(pk, comms, witnesses, vector<size_t>(items.begin(), items.begin() + half), failed);
+    findFailures(pk, comms, witnesses, vector<size_t>(items.begin() + half, items.end()), failed);
+}
+
+bool verifyEvalBatch(const KZG::PublicKey &pk, const vector<KZG::Commitment> &comms, const vector<KZG::Witness> &witnesses, vector<size_t> *failed) {
+    PROFILE_SPAN("verifyEvalBatch");
+    if (comms.size() != witnesses.size()) throw runtime_error("Need one witness per commitment.");
+    if (failed) failed->clear();
+    if (comms.empty()) return true;
+
+    vector<size_t> items(comms.size());
+    for (size_t k = 0; k < items.size(); k++) items[k] = k;
+
+    if (checkFolded(pk, comms, witnesses, items)) return true;
+
+    // Only a rejected batch pays for locating the bad openings
+    if (failed) findFailures(pk, comms, witnesses, items, *failed);
+    return false;
+}
+
+KZG::BatchWitness createBatchWitness(const KZG::PublicKey &pk, const vector<PolyView> &polys, const Fr &i, Transcript &transcript) {
+    PROFILE_SPAN("createBatchWitness");
+    KZG::BatchWitness witness;
+    witness.i = i;
+    witness.qi.resize(polys.size());
+
+    size_t size = 0;
+    for (size_t k = 0; k < polys.size(); k++) {
+        witness.qi[k] = evaluatePoly(polys[k], i);
+        transcript.absorb("batch_eval", witness.qi[k]);
+        size = max(size, polys[k].size);
+    }
+
+    // h = sum_k gamma^k p_k, opened once at i
+    Fr gamma = transcript.challenge("batch_gamma");
+    ArenaScope scratch;
+    Fr *h = scratch.allocFr(size);
+    Fr power = 1;
+    for (const auto &p : polys) {
+        for (size_t j = 0; j < p.size; j++) h[j] += power * p[j];
+        power *= gamma;
+    }
+
+    witness.w = openAt(pk, PolyView(h, size), i).w;
     return witness;
 }
 
-bool verifyEval(KZG::PublicKey pk, KZG::Commitment comm, Fr i, KZG::Witness witness) {
-    GT left, right1, right2;
-    pairing(left, comm.c, pk.g2[0]); // e(C, g)
+bool verifyBatchEval(const KZG::PublicKey &pk, const vector<KZG::Commitment> &comms, const Fr &i, const KZG::BatchWitness &witness, Transcript &transcript) {
+    PROFILE_SPAN("verifyBatchEval");
+    if (comms.size() != witness.qi.size()) return false;
 
-    G2 gi;
-    G2::mul(gi, pk.g2[0], i); // g^i
+    for (const auto &v : witness.qi) transcript.absorb("batch_eval", v);
+    Fr gamma = transcript.challenge("batch_gamma");
 
-    G2 temp;
-    G2::sub(temp, pk.g2[1], gi); // g^a / g^i
-    pairing(right1, witness.w, temp); // e(w_i, g^a / g^i)
+    // C = sum_k gamma^k C_k must open to v = sum_k gamma^k v_k
+    vector<G1> points(comms.size());
+    vector<Fr> powers(comms.size());
+    Fr power = 1, v = 0;
+    for (size_t k = 0; k < comms.size(); k++) {
+        points[k] = comms[k].c;
+        powers[k] = power;
+        v += power * witness.qi[k];
+        power *= gamma;
+    }
 
-    pairing(right2, pk.g1[0], pk.g2[0]); // e(g,g)
-    
-    GT right;
-    GT::pow(right, right2, witness.qi);
-    GT::mul(right, right1, right);
+    G1 c;
+    msmG1(c, points.data(), powers.data(), points.size());
+    return checkOpening(pk, c, i, witness.w, v);
+}
 
-    return left == right;
+// Union T of all opening points, throws on a repeated point within one set
+static vector<Fr> pointUnion(const vector<vector<Fr>> &points) {
+    vector<Fr> all;
+    for (const auto &set : points) {
+        for (size_t j = 0; j < set.size(); j++) {
+            for (size_t m = 0; m < j; m++) {
+                if (set[m] == set[j]) throw runtime_error("Opening points must be distinct.");
+            }
+            if (find(all.begin(), all.end(), set[j]) == all.end()) all.push_back(set[j]);
+        }
+    }
+    return all;
+}
+
+// Z_{T \ S}(z) = product of (z - t) over the points of T missing from S
+static Fr vanishingOutside(const vector<Fr> &all, const vector<Fr> &set, const Fr &z) {
+    Fr result = 1;
+    for (const auto &t : all) {
+        if (find(set.begin(), set.end(), t) == set.end()) result *= z - t;
+    }
+    return result;
+}
+
+// r(z) for the polynomial of degree < |S| through (S[j], values[j])
+static Fr interpolateAt(const vector<Fr> &set, const vector<Fr> &values, const Fr &z) {
+    Fr result = 0;
+    PROFILE_COUNT(FieldInversion, set.size());
+    for (size_t j = 0; j < set.size(); j++) {
+        Fr num = 1, den = 1;
+        for (size_t m = 0; m < set.size(); m++) {
+            if (m == j) continue;
+            num *= z - set[m];
+            den *= set[j] - set[m];
+        }
+        result += values[j] * num / den;
+    }
+    return result;
+}
+
+static void absorbEvals(Transcript &transcript, const vector<vector<Fr>> &points, const vector<vector<Fr>> &evals) {
+    for (size_t k = 0; k < points.size(); k++) {
+        for (size_t j = 0; j < points[k].size(); j++) {
+            transcript.absorb("multi_point", points[k][j]);
+            transcript.absorb("multi_eval", evals[k][j]);
+        }
+    }
+}
+
+KZG::MultiPointWitness createMultiPointWitness(const KZG::PublicKey &pk, const vector<PolyView> &polys, const vector<vector<Fr>> &points, Transcript &transcript) {
+    PROFILE_SPAN("createMultiPointWitness");
+    if (polys.size() != points.size()) throw runtime_error("Need one point set per polynomial.");
+    vector<Fr> all = pointUnion(points);
+
+    KZG::MultiPointWitness witness;
+    witness.qi.resize(polys.size());
+    size_t size = 0;
+    for (size_t k = 0; k < polys.size(); k++) {
+        for (const auto &x : points[k]) witness.qi[k].push_back(evaluatePoly(polys[k], x));
+        size = max(size, polys[k].size);
+    }
+    absorbEvals(transcript, points, witness.qi);
+    Fr gamma = transcript.challenge("multi_gamma");
+
+    // (p_k - r_k) / Z_{S_k} is the quotient of dividing p_k by each (X - x) in
+    // turn, the dropped remainders add up to r_k
+    ArenaScope scratch;
+    Fr *h = scratch.allocFr(size);
+    Fr *quotient = scratch.allocFr(size), *next = scratch.allocFr(size);
+    Fr power = 1;
+    for (size_t k = 0; k < polys.size(); k++) {
+        PolyView current = polys[k];
+        for (const auto &x : points[k]) {
+            if (current.size <= 1) {
+                current = PolyView();
+                break;
+            }
+            divideByLinear(current, x, next);
+            swap(quotient, next);
+            current = PolyView(quotient, current.size - 1);
+        }
+        for (size_t j = 0; j < current.size; j++) h[j] += power * current[j];
+        power *= gamma;
+    }
+    msmG1(witness.w, pk.g1.data(), h, size);
+
+    transcript.absorb("multi_w", witness.w);
+    Fr z = transcript.challenge("multi_z");
+
+    // L(X) = sum_k gamma^k Z_{T \ S_k}(z) (p_k(X) - r_k(z)) - Z_T(z) h(X) vanishes
+    // at z. The constant r_k(z) terms do not change the quotient by (X - z),
+    // so openAt() can work on L without them.
+    Fr *L = scratch.allocFr(size);
+    power = 1;
+    for (size_t k = 0; k < polys.size(); k++) {
+        Fr scale = power * vanishingOutside(all, points[k], z);
+        for (size_t j = 0; j < polys[k].size; j++) L[j] += scale * polys[k][j];
+        power *= gamma;
+    }
+    Fr zt = vanishingOutside(all, vector<Fr>(), z);
+    for (size_t j = 0; j < size; j++) L[j] -= zt * h[j];
+
+    witness.w_z = openAt(pk, PolyView(L, size), z).w;
+    return witness;
+}
+
+bool verifyMultiPointEval(const KZG::PublicKey &pk, const vector<KZG::Commitment> &comms, const vector<vector<Fr>> &points, const KZG::MultiPointWitness &witness, Transcript &transcript) {
+    PROFILE_SPAN("verifyMultiPointEval");
+    if (comms.size() != points.size() || witness.qi.size() != points.size()) return false;
+    for (size_t k = 0; k < points.size(); k++) {
+        if (witness.qi[k].size() != points[k].size()) return false;
+    }
+    vector<Fr> all = pointUnion(points);
+
+    absorbEvals(transcript, points, witness.qi);
+    Fr gamma = transcript.challenge("multi_gamma");
+    transcript.absorb("multi_w", witness.w);
+    Fr z = transcript.challenge("multi_z");
+
+    // F = sum_k gamma^k Z_{T \ S_k}(z) (C_k - r_k(z) g) - Z_T(z) W commits to L
+    vector<G1> bases(comms.size() + 2);
+    vector<Fr> scalars(comms.size() + 2);
+    Fr power = 1, constant = 0;
+    for (size_t k = 0; k < comms.size(); k++) {
+        Fr scale = power * vanishingOutside(all, points[k], z);
+        bases[k] = comms[k].c;
+        scalars[k] = scale;
+        constant += scale * interpolateAt(points[k], witness.qi[k], z);
+        power *= gamma;
+    }
+    bases[comms.size()] = pk.g1[0];
+    scalars[comms.size()] = -constant;
+    bases[comms.size() + 1] = witness.w;
+    scalars[comms.size() + 1] = -vanishingOutside(all, vector<Fr>(), z);
+
+    G1 F;
+    msmG1(F, bases.data(), scalars.data(), bases.size());
+
+    // L(z) = 0, so F opens to 0 at z with witness w_z
+    return checkOpening(pk, F, z, witness.w_z, Fr(0));
+}
+
+void setupLagrange(KZG::PublicKey &pk, size_t n) {
+    if (n == 0 || (n & (n - 1)) != 0) throw runtime_error("Domain size must be a power of 2.");
+    if (n > pk.g1.size()) throw runtime_error("Domain size exceeds the SRS degree.");
+    if (pk.lagrange.count(n)) return;
+
+    // [L_i(a)] = (1/n) sum_j w^(-ij) [a^j], the inverse NTT of the monomial SRS
+    vector<G1> basis(pk.g1.begin(), pk.g1.begin() + n);
+    ntt_inverse_g1(basis, findPrimitiveRoot(n));
+    pk.lagrange[n] = basis;
+}
+
+static const vector<G1> &lagrangeBasis(const KZG::PublicKey &pk, size_t n) {
+    auto it = pk.lagrange.find(n);
+    if (it == pk.lagrange.end()) throw runtime_error("Lagrange basis not set up for this domain size.");
+    return it->second;
+}
+
+// Replaces every element with its inverse using a single field inversion
+static void batchInverse(Fr *a, size_t n) {
+    if (n == 0) return;
+
+    ArenaScope scratch;
+    Fr *prefix = scratch.allocFr(n);
+    Fr acc = 1;
+    for (size_t j = 0; j < n; j++) {
+        prefix[j] = acc;
+        acc *= a[j];
+    }
+
+    PROFILE_COUNT(FieldInversion, 1);
+    Fr::inv(acc, acc);
+    for (size_t j = n; j-- > 0;) {
+        Fr inv = acc * prefix[j];
+        acc *= a[j];
+        a[j] = inv;
+    }
+}
+
+KZG::Commitment commitLagrange(const KZG::PublicKey &pk, PolyView evals) {
+    PROFILE_SPAN("commitLagrange");
+    const vector<G1> &basis = lagrangeBasis(pk, evals.size);
+
+    KZG::Commitment comm;
+    msmG1(comm.c, basis.data(), evals.data, evals.size);
+
+    return comm;
+}
+
+KZG::Witness createWitnessLagrange(const KZG::PublicKey &pk, PolyView evals, const Fr &i) {
+    PROFILE_SPAN("createWitnessLagrange");
+    size_t n = evals.size;
+    const vector<G1> &basis = lagrangeBasis(pk, n);
+
+    ArenaScope scratch;
+    Fr *domain = scratch.allocFr(n);
+    Fr omega = findPrimitiveRoot(n), power = 1;
+    size_t k = n; // Index of i in the domain, n if i is outside it
+    for (size_t j = 0; j < n; j++) {
+        domain[j] = power;
+        if (power == i) k = j;
+        power *= omega;
+    }
+
+    KZG::Witness witness;
+    witness.i = i;
+
+    // diff[j] = 1 / (w^j - i), skipping the zero denominator when i = w^k
+    Fr *diff = scratch.allocFr(n);
+    for (size_t j = 0; j < n; j++) diff[j] = j == k ? Fr(1) : domain[j] - i;
+    batchInverse(diff, n);
+
+    if (k == n) {
+        // Barycentric formula q(i) = (i^n - 1)/n * sum_j evals[j] w^j / (i - w^j)
+        Fr sum = 0;
+        for (size_t j = 0; j < n; j++) sum -= evals[j] * domain[j] * diff[j];
+
+        Fr zi;
+        Fr::pow(zi, i, n);
+        PROFILE_COUNT(FieldInversion, 1);
+        witness.qi = (zi - 1) * sum / n;
+    } else {
+        witness.qi = evals[k];
+    }
+
+    // Quotient (q(x) - q(i)) / (x - i) in evaluation form
+    Fr *quotient = scratch.allocFr(n);
+    for (size_t j = 0; j < n; j++) {
+        if (j != k) quotient[j] = (evals[j] - witness.qi) * diff[j];
+    }
+
+    // At x = i = w^k the quotient is q'(w^k) = -sum_{j != k} quotient[j] * w^(j-k)
+    if (k != n) {
+        Fr sum = 0;
+        for (size_t j = 0; j < n; j++) {
+            if (j != k) sum += quotient[j] * domain[(j + n - k) % n];
+        }
+        quotient[k] = -sum;
+    }
+
+    msmG1(witness.w, basis.data(), quotient, n);
+
+    return witness;
 }
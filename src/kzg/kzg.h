@@ -2,19 +2,100 @@
 #define KZG_H
 
 #include <mcl/bn.hpp>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <vector>
+#include "../transcript/transcript.h"
 
 using namespace mcl;
 using namespace bn;
 using namespace std;
 
+// Non-owning read-only view of a coefficient (or evaluation) vector. It
+// converts implicitly from vector<Fr>, which must outlive the view.
+struct PolyView {
+    const Fr *data;
+    size_t size;
+
+    PolyView() : data(nullptr), size(0) {}
+    PolyView(const vector<Fr> &v) : data(v.data()), size(v.size()) {}
+    PolyView(const Fr *data, size_t size) : data(data), size(size) {}
+
+    const Fr &operator[](size_t j) const { return data[j]; }
+    bool empty() const { return size == 0; }
+};
+
+/**
+ * @brief Points owned in a vector, or read in place from shared storage
+ *
+ * loadSRS() points the arrays of a Raw SRS file at its mapping, which storage
+ * keeps alive for as long as any array still uses it. A copy always owns its
+ * points, so writing through it never reaches the shared storage.
+ */
+template <class G>
+class PointArray {
+public:
+    PointArray() : mapped(nullptr), mapped_size(0) {}
+    PointArray(shared_ptr<void> storage, G *points, size_t count) : storage(storage), mapped(points), mapped_size(count) {}
+    PointArray(const PointArray &other) : owned(other.begin(), other.end()), mapped(nullptr), mapped_size(0) {}
+    PointArray(PointArray &&other) = default;
+
+    PointArray &operator=(const PointArray &other) {
+        if (this != &other) {
+            owned.assign(other.begin(), other.end());
+            storage.reset();
+        }
+        return *this;
+    }
+    PointArray &operator=(PointArray &&other) = default;
+
+    size_t size() const { return storage ? mapped_size : owned.size(); }
+    bool empty() const { return size() == 0; }
+    bool isMapped() const { return storage != nullptr; }
+
+    G *data() { return storage ? mapped : owned.data(); }
+    const G *data() const { return storage ? mapped : owned.data(); }
+    G &operator[](size_t i) { return data()[i]; }
+    const G &operator[](size_t i) const { return data()[i]; }
+    G *begin() { return data(); }
+    G *end() { return data() + size(); }
+    const G *begin() const { return data(); }
+    const G *end() const { return data() + size(); }
+
+    // Copies mapped points into owned storage first
+    void resize(size_t n) {
+        if (storage) {
+            owned.assign(mapped, mapped + min(n, mapped_size));
+            storage.reset();
+        }
+        owned.resize(n);
+    }
+
+    bool operator==(const PointArray &other) const { return size() == other.size() && equal(begin(), end(), other.begin()); }
+    bool operator!=(const PointArray &other) const { return !(*this == other); }
+
+private:
+    vector<G> owned;
+    shared_ptr<void> storage; // Set while the points live in shared storage
+    G *mapped;
+    size_t mapped_size;
+};
+
 class KZG {
 public:
     struct PublicKey {
-        vector<G1> g1; 
-        vector<G2> g2;
+        PointArray<G1> g1; 
+        PointArray<G2> g2;
         size_t t; 
+        map<size_t, vector<G1>> lagrange; // Domain size n -> [L_i(a)] for i < n, see setupLagrange()
+        vector<Fp6> g2_lines; // Miller loop line coefficients of g2[0], see prepareVerifier()
+        vector<Fp6> g2a_lines; // and of g2[1]
     };
 
+    // Immutable key shared between provers and verifiers without copying
+    typedef shared_ptr<const PublicKey> SRSHandle;
+
     struct Commitment {
         G1 c;
     };
@@ -24,18 +105,88 @@ public:
         G1 w; // Witness
         Fr qi; // Evaluated value
     };
+
+    // Opening of several polynomials at the same point with one witness
+    struct BatchWitness {
+        Fr i;
+        G1 w; // Witness for sum_k gamma^k p_k
+        vector<Fr> qi; // Evaluated value of each polynomial
+    };
+
+    // Opening of several polynomials, each at its own set of points, with two
+    // witnesses (Shplonk, BDFG20)
+    struct MultiPointWitness {
+        G1 w; // Commitment to h = sum_k gamma^k (p_k - r_k) / Z_{S_k}
+        G1 w_z; // Witness for the linearised L(X) at the challenge z
+        vector<vector<Fr>> qi; // qi[k][j] = p_k(points[k][j])
+    };
 };
 
-KZG::PublicKey setup(size_t t);
+// With g2_powers = false only g2[0] = g and g2[1] = g^a are generated,
+// which is all verifyEval() needs.
+KZG::PublicKey setup(size_t t, bool g2_powers = true);
+
+// Precomputes the G2 line coefficients every verifier uses. setup() and
+// loadSRS() call it, a key built by hand works without it but verifies slower.
+void prepareVerifier(KZG::PublicKey &pk);
+
+// Moves the key behind a shared handle, run setupLagrange() first if needed
+KZG::SRSHandle shareKey(KZG::PublicKey &&pk);
+
+KZG::Commitment commit(const KZG::PublicKey &pk, PolyView q);
+
+Fr evaluatePoly(PolyView q, const Fr &i);
+
+// Writes the q.size - 1 coefficients of q / (x - i) to quotient and returns the
+// remainder, which is q(i). Large inputs are split into per-thread blocks that
+// divide independently and are then corrected by powers of i.
+Fr divideByLinear(PolyView q, const Fr &i, Fr *quotient);
+
+vector<Fr> divideByLinear(PolyView q, const Fr &i);
+
+KZG::Witness createWitness(const KZG::PublicKey &pk, PolyView q, const Fr &i);
+
+bool verifyEval(const KZG::PublicKey &pk, const KZG::Commitment &comm, const Fr &i, const KZG::Witness &witness);
+
+// Verifies witnesses[k] against comms[k] for every k with one multi-Miller loop
+// and one final exponentiation, after folding the openings with random scalars.
+// If the batch rejects and failed is given, it receives the indices of the
+// openings that do not verify.
+bool verifyEvalBatch(const KZG::PublicKey &pk, const vector<KZG::Commitment> &comms, const vector<KZG::Witness> &witnesses, vector<size_t> *failed = nullptr);
+
+// Opens every polynomial at i with a single witness. The evaluations are
+// absorbed into the transcript before the combining challenge gamma is drawn.
+// The commitments and i are not absorbed: the caller must have absorbed the
+// commitments of polys, and derived i from the transcript, before calling,
+// otherwise gamma does not bind them.
+KZG::BatchWitness createBatchWitness(const KZG::PublicKey &pk, const vector<PolyView> &polys, const Fr &i, Transcript &transcript);
+
+// Checks a batch opening with one combined pairing check. The transcript must be
+// in the same state as the prover's was when it called createBatchWitness(), and
+// comms and i are not absorbed here, so that state must already bind them.
+bool verifyBatchEval(const KZG::PublicKey &pk, const vector<KZG::Commitment> &comms, const Fr &i, const KZG::BatchWitness &witness, Transcript &transcript);
 
-KZG::Commitment commit(KZG::PublicKey pk, vector<Fr> q);
+// Opens polys[k] at every point of points[k] (distinct within each set). The
+// proof is two G1 elements plus the evaluations for any number of points, and
+// the prover runs two MSMs of the SRS degree. The points and evaluations are
+// absorbed, the commitments are not: the caller must have absorbed the
+// commitments of polys before calling, otherwise gamma and z do not bind them.
+KZG::MultiPointWitness createMultiPointWitness(const KZG::PublicKey &pk, const vector<PolyView> &polys, const vector<vector<Fr>> &points, Transcript &transcript);
 
-Fr evaluatePoly(vector<Fr> q, Fr i);
+// Checks a multi-point opening with one MSM and two pairings. The transcript must
+// be in the same state as the prover's was when it called createMultiPointWitness(),
+// and comms are not absorbed here, so that state must already bind them.
+bool verifyMultiPointEval(const KZG::PublicKey &pk, const vector<KZG::Commitment> &comms, const vector<vector<Fr>> &points, const KZG::MultiPointWitness &witness, Transcript &transcript);
 
-vector<Fr> divideByLinear(vector<Fr> q, Fr i);
+// Computes the Lagrange-basis SRS for the domain of size n (a power of two,
+// n <= t+1) generated by findPrimitiveRoot(n), via an inverse NTT over G1.
+void setupLagrange(KZG::PublicKey &pk, size_t n);
 
-KZG::Witness createWitness(KZG::PublicKey pk, vector<Fr> q, Fr i);
+// Commits to the polynomial with evals[j] = q(w^j), w = findPrimitiveRoot(n).
+// The result equals commit() of the interpolated coefficients.
+KZG::Commitment commitLagrange(const KZG::PublicKey &pk, PolyView evals);
 
-bool verifyEval(KZG::PublicKey pk, KZG::Commitment comm, Fr i, KZG::Witness witness);
+// Opens the polynomial given by its evaluations at i, without interpolating.
+KZG::Witness createWitnessLagrange(const KZG::PublicKey &pk, PolyView evals, const Fr &i);
 
 #endif // KZG_H
@@ -0,0 +1,195 @@
+#include "msm.h"
+#include "../parallel/parallel.h"
+#include "../profile/profile.h"
+#include <mcl/bn.hpp>
+#include <cstdint>
+#include <cmath>
+
+using namespace std;
+using namespace mcl;
+using namespace bn;
+
+// Below this size bucket setup costs more than it saves
+static const size_t MSM_NAIVE_THRESHOLD = 32;
+
+// Minimum number of terms handed to a single thread
+static const size_t MSM_THREAD_GRAIN = 1024;
+
+size_t msmWindowSize(size_t n) {
+    if (n < MSM_NAIVE_THRESHOLD) return 3;
+
+    // ln(n) + 2, the usual optimum for Pippenger with signed digits
+    size_t c = (size_t)log((double)n) + 2;
+    return min(c, (size_t)16);
+}
+
+void msmG1Naive(G1 &out, const G1 *bases, const Fr *scalars, size_t n) {
+    PROFILE_COUNT(G1Mul, n);
+    out.clear();
+
+    for (size_t i = 0; i < n; i++) {
+        G1 temp;
+        G1::mul(temp, bases[i], scalars[i]);
+        G1::add(out, out, temp);
+    }
+}
+
+// Copies the canonical (non-Montgomery) value of k into 64-bit limbs
+static void scalarLimbs(uint64_t *limbs, size_t L, const Fr &k) {
+    fp::Block b;
+    k.getBlock(b);
+
+    for (size_t i = 0; i < L; i++) limbs[i] = 0;
+
+    const size_t unitBits = sizeof(b.p[0]) * 8;
+    for (size_t i = 0; i < b.n; i++) {
+        size_t bit = i * unitBits;
+        limbs[bit / 64] |= (uint64_t)b.p[i] << (bit % 64);
+    }
+}
+
+// Writes k + sum_w 2^(w*c + c-1) into limbs. Reading window w of the result and
+// subtracting 2^(c-1) yields the signed digit in [-2^(c-1), 2^(c-1)).
+static void recodeScalar(uint64_t *limbs, size_t L, const Fr &k, size_t c, size_t windows) {
+    scalarLimbs(limbs, L, k);
+
+    for (size_t w = 0; w < windows; w++) {
+        size_t bit = w * c + c - 1;
+        size_t j = bit / 64;
+        uint64_t add = (uint64_t)1 << (bit % 64);
+
+        // Propagate the carry through the higher limbs
+        while (j < L) {
+            limbs[j] += add;
+            if (limbs[j] >= add) break;
+            add = 1;
+            j++;
+        }
+    }
+}
+
+// Unsigned c-bit window w of k, limbs must have one spare limb on top
+static uint32_t unsignedDigit(const uint64_t *limbs, size_t w, size_t c) {
+    size_t bit = w * c;
+    size_t j = bit / 64, shift = bit % 64;
+
+    uint64_t v = limbs[j] >> shift;
+    if (shift + c > 64) v |= limbs[j + 1] << (64 - shift);
+    return (uint32_t)(v & (((uint64_t)1 << c) - 1));
+}
+
+static int32_t signedDigit(const uint64_t *limbs, size_t w, size_t c) {
+    return (int32_t)unsignedDigit(limbs, w, c) - ((int32_t)1 << (c - 1));
+}
+
+static void pippenger(G1 &out, const G1 *bases, const Fr *scalars, size_t n) {
+    size_t c = msmWindowSize(n);
+    // Two spare bits keep k + offset from overflowing the top window
+    size_t windows = (Fr::getBitSize() + 2 + c - 1) / c;
+    size_t L = (windows * c + 63) / 64 + 1;
+
+    vector<uint64_t> limbs(n * L);
+    for (size_t i = 0; i < n; i++) {
+        recodeScalar(&limbs[i * L], L, scalars[i], c, windows);
+    }
+
+    vector<G1> buckets((size_t)1 << (c - 1));
+    out.clear();
+
+    for (size_t w = windows; w-- > 0;) {
+        for (size_t k = 0; k < c; k++) G1::dbl(out, out);
+
+        for (auto &b : buckets) b.clear();
+
+        for (size_t i = 0; i < n; i++) {
+            int32_t d = signedDigit(&limbs[i * L], w, c);
+            if (d > 0) G1::add(buckets[d - 1], buckets[d - 1], bases[i]);
+            else if (d < 0) G1::sub(buckets[-d - 1], buckets[-d - 1], bases[i]);
+        }
+
+        // sum_b (b+1) * buckets[b] via running sums from the top bucket down
+        G1 running, acc;
+        running.clear();
+        acc.clear();
+        for (size_t b = buckets.size(); b-- > 0;) {
+            G1::add(running, running, buckets[b]);
+            G1::add(acc, acc, running);
+        }
+
+        G1::add(out, out, acc);
+    }
+}
+
+void msmG1(G1 &out, const G1 *bases, const Fr *scalars, size_t n, size_t threads) {
+    PROFILE_SPAN("msm");
+    PROFILE_COUNT(MSMPoints, n);
+    if (n < MSM_NAIVE_THRESHOLD) {
+        msmG1Naive(out, bases, scalars, n);
+        return;
+    }
+
+    if (threads == 0) threads = getThreadCount();
+    threads = max((size_t)1, min(threads, n / MSM_THREAD_GRAIN));
+
+    // Called from inside another parallelFor, the whole range runs as chunk 0
+    // and the other partial sums are never written
+    vector<G1> partial(threads);
+    for (auto &p : partial) p.clear();
+    parallelFor(n, [&](size_t begin, size_t end, size_t chunk) {
+        pippenger(partial[chunk], bases + begin, scalars + begin, end - begin);
+    }, threads);
+
+    out = partial[0];
+    for (size_t t = 1; t < threads; t++) {
+        G1::add(out, out, partial[t]);
+    }
+}
+
+// Below this many scalars a plain G::mul per scalar beats building the table
+static const size_t FIXED_BASE_THRESHOLD = 16;
+
+template <class G>
+static void fixedBaseMul(G *out, const G &base, const Fr *scalars, size_t n, size_t threads) {
+    if (n < FIXED_BASE_THRESHOLD) {
+        for (size_t i = 0; i < n; i++) G::mul(out[i], base, scalars[i]);
+        return;
+    }
+
+    size_t c = n < 1024 ? 4 : 8;
+    size_t windows = (Fr::getBitSize() + c - 1) / c;
+    size_t L = (windows * c + 63) / 64 + 1;
+    size_t width = (size_t)1 << c;
+
+    // table[w * width + d] = d * 2^(w*c) * base
+    vector<G> table(windows * width);
+    G row = base;
+    for (size_t w = 0; w < windows; w++) {
+        G *entry = &table[w * width];
+        entry[0].clear();
+        entry[1] = row;
+        for (size_t d = 2; d < width; d++) G::add(entry[d], entry[d - 1], row);
+        G::add(row, entry[width - 1], row);
+    }
+
+    parallelFor(n, [&](size_t begin, size_t end, size_t) {
+        vector<uint64_t> limbs(L);
+        for (size_t i = begin; i < end; i++) {
+            scalarLimbs(limbs.data(), L, scalars[i]);
+            out[i].clear();
+            for (size_t w = 0; w < windows; w++) {
+                uint32_t d = unsignedDigit(limbs.data(), w, c);
+                if (d != 0) G::add(out[i], out[i], table[w * width + d]);
+            }
+        }
+    }, threads, FIXED_BASE_THRESHOLD);
+}
+
+void fixedBaseMulG1(G1 *out, const G1 &base, const Fr *scalars, size_t n, size_t threads) {
+    PROFILE_COUNT(G1Mul, n);
+    fixedBaseMul(out, base, scalars, n, threads);
+}
+
+void fixedBaseMulG2(G2 *out, const G2 &base, const Fr *scalars, size_t n, size_t threads) {
+    PROFILE_COUNT(G2Mul, n);
+    fixedBaseMul(out, base, scalars, n, threads);
+}
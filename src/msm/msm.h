@@ -0,0 +1,64 @@
+#ifndef MSM_H
+#define MSM_H
+
+#include <mcl/bn.hpp>
+#include <vector>
+
+using namespace mcl;
+using namespace bn;
+using namespace std;
+
+/**
+ * @brief Picks the Pippenger window size (in bits) for an MSM of n terms
+ * @param n Number of (base, scalar) pairs
+ * @return Window size c, buckets per window are 2^(c-1)
+ */
+size_t msmWindowSize(size_t n);
+
+/**
+ * @brief Computes the multi-scalar multiplication sum_i scalars[i] * bases[i]
+ * @param out Result point
+ * @param bases Array of n G1 points
+ * @param scalars Array of n scalars
+ * @param n Number of terms
+ * @param threads Number of threads, 0 uses getThreadCount()
+ *
+ * Uses bucketed Pippenger with signed-digit recoding of the scalars. The input
+ * is split into one contiguous chunk per thread, every chunk accumulates its
+ * own buckets and the partial sums are added at the end.
+ */
+void msmG1(G1 &out, const G1 *bases, const Fr *scalars, size_t n, size_t threads = 0);
+
+/**
+ * @brief Reference MSM computing one G1::mul and one G1::add per term
+ * @param out Result point
+ * @param bases Array of n G1 points
+ * @param scalars Array of n scalars
+ * @param n Number of terms
+ */
+void msmG1Naive(G1 &out, const G1 *bases, const Fr *scalars, size_t n);
+
+/**
+ * @brief Multiplies one fixed G1 base by many scalars
+ * @param out Output array of n points, out[i] = scalars[i] * base
+ * @param base The fixed base point
+ * @param scalars Array of n scalars
+ * @param n Number of scalars
+ * @param threads Number of threads, 0 uses getThreadCount()
+ *
+ * Precomputes a windowed table of d * 2^(w*c) * base once, after which each
+ * product costs one addition per window and no doublings.
+ */
+void fixedBaseMulG1(G1 *out, const G1 &base, const Fr *scalars, size_t n, size_t threads = 0);
+
+/**
+ * @brief Multiplies one fixed G2 base by many scalars
+ * @param out Output array of n points, out[i] = scalars[i] * base
+ * @param base The fixed base point
+ * @param scalars Array of n scalars
+ * @param n Number of scalars
+ * @param threads Number of threads, 0 uses getThreadCount()
+ */
+void fixedBaseMulG2(G2 *out, const G2 &base, const Fr *scalars, size_t n, size_t threads = 0);
+
+#endif // MSM_H
@@ -0,0 +1,116 @@
+#include "multipoint.h"
+#include "../kzg/kzg.h"
+#include "../poly/polynomial.h"
+#include "../profile/profile.h"
+#include <mcl/bn.hpp>
+#include <stdexcept>
+
+using namespace std;
+using namespace mcl;
+using namespace bn;
+
+// Ranges up to this size are evaluated with Horner and combined directly
+static const size_t SUBPRODUCT_LEAF = 32;
+
+SubproductTree::SubproductTree(const vector<Fr> &points) : points(points) {
+    if (points.empty()) throw runtime_error("Subproduct tree needs at least one point.");
+    build(0, points.size());
+}
+
+// Builds the node for points [lo, hi) after its children, returns its index
+size_t SubproductTree::build(size_t lo, size_t hi) {
+    size_t k = nodes.size();
+    nodes.push_back(Node{lo, hi, 0, 0});
+    divisors.push_back(PolynomialDivisor(vector<Fr>(1, Fr(1)))); // Replaced once the product is known
+
+    vector<Fr> product;
+    if (hi - lo <= SUBPRODUCT_LEAF) {
+        // prod (x - x_j), multiplying in one linear factor at a time
+        product.assign(1, Fr(1));
+        for (size_t j = lo; j < hi; j++) {
+            product.push_back(0);
+            for (size_t i = product.size() - 1; i > 0; i--) product[i] = product[i - 1] - points[j] * product[i];
+            product[0] = -points[j] * product[0];
+        }
+    } else {
+        size_t mid = lo + (hi - lo) / 2;
+        size_t left = build(lo, mid);
+        size_t right = build(mid, hi);
+        nodes[k].left = left;
+        nodes[k].right = right;
+        product = multiplyPolys(divisors[left].polynomial(), divisors[right].polynomial());
+    }
+
+    divisors[k] = PolynomialDivisor(product);
+    return k;
+}
+
+void SubproductTree::evaluateNode(size_t k, PolyView remainder, vector<Fr> &out) {
+    const Node &node = nodes[k];
+    if (node.left == 0) {
+        for (size_t j = node.lo; j < node.hi; j++) out[j] = evaluatePoly(remainder, points[j]);
+        return;
+    }
+
+    vector<Fr> quotient, child;
+    for (size_t c : {node.left, node.right}) {
+        divisors[c].divide(remainder, quotient, child);
+        evaluateNode(c, child, out);
+    }
+}
+
+vector<Fr> SubproductTree::evaluate(PolyView q) {
+    vector<Fr> quotient, remainder;
+    divisors[0].divide(q, quotient, remainder);
+
+    vector<Fr> out(points.size());
+    evaluateNode(0, remainder, out);
+    return out;
+}
+
+// sum_{j in node} c_j M(x) / (x - x_j) for the node's M
+vector<Fr> SubproductTree::combineNode(size_t k, const vector<Fr> &c) {
+    const Node &node = nodes[k];
+    const vector<Fr> &m = divisors[k].polynomial();
+
+    if (node.left == 0) {
+        vector<Fr> result(m.size() - 1, 0);
+        for (size_t j = node.lo; j < node.hi; j++) {
+            vector<Fr> term = divideByLinear(m, points[j]);
+            for (size_t i = 0; i < term.size(); i++) result[i] += c[j] * term[i];
+        }
+        return result;
+    }
+
+    // left part times M_right plus right part times M_left
+    vector<Fr> result = multiplyPolys(combineNode(node.left, c), divisors[node.right].polynomial());
+    vector<Fr> right = multiplyPolys(combineNode(node.right, c), divisors[node.left].polynomial());
+    result.resize(m.size() - 1, 0);
+    for (size_t i = 0; i < right.size() && i < result.size(); i++) result[i] += right[i];
+    return result;
+}
+
+vector<Fr> SubproductTree::interpolate(const vector<Fr> &values) {
+    if (values.size() != points.size()) throw runtime_error("Need one value per interpolation point.");
+
+    if (weights.empty()) {
+        // Z'(x_j) = prod_{i != j} (x_j - x_i), zero iff x_j is repeated
+        const vector<Fr> &z = vanishing();
+        vector<Fr> derivative(z.size() - 1);
+        for (size_t i = 1; i < z.size(); i++) derivative[i - 1] = z[i] * Fr(i);
+
+        weights = evaluate(derivative);
+        for (auto &w : weights) {
+            if (w.isZero()) {
+                weights.clear();
+                throw runtime_error("Interpolation points must be distinct.");
+            }
+            PROFILE_COUNT(FieldInversion, 1);
+            Fr::inv(w, w);
+        }
+    }
+
+    vector<Fr> c(points.size());
+    for (size_t j = 0; j < c.size(); j++) c[j] = values[j] * weights[j];
+    return combineNode(0, c);
+}
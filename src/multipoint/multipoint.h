@@ -0,0 +1,60 @@
+#ifndef MULTIPOINT_H
+#define MULTIPOINT_H
+
+#include <mcl/bn.hpp>
+#include <vector>
+#include "../kzg/kzg.h"
+#include "../poly/polynomial.h"
+
+using namespace mcl;
+using namespace bn;
+using namespace std;
+
+/**
+ * @brief Subproduct tree over an arbitrary point set
+ *
+ * Each node holds M(x) = prod (x - x_j) over a contiguous range of the
+ * points, the root holds the vanishing polynomial of the whole set. Nodes
+ * keep their PolynomialDivisor, so the Newton inverses are paid for once and
+ * every later evaluate()/interpolate() on the same points reuses them.
+ *
+ * Both operations are O(n log^2 n) for n points. Ranges of at most
+ * SUBPRODUCT_LEAF points are handled directly, which is faster than
+ * recursing on tiny polynomials.
+ *
+ * The cached inverses grow on use, so a tree must not be queried from
+ * several threads at once.
+ */
+class SubproductTree {
+public:
+    explicit SubproductTree(const vector<Fr> &points);
+
+    size_t size() const { return points.size(); }
+
+    // prod (x - x_j) over all points
+    const vector<Fr> &vanishing() const { return divisors[0].polynomial(); }
+
+    // q(x_j) for every point, by reducing q down the tree
+    vector<Fr> evaluate(PolyView q);
+
+    // Coefficients of the polynomial of degree < size() with p(x_j) = values[j].
+    // Throws if the points are not distinct.
+    vector<Fr> interpolate(const vector<Fr> &values);
+
+private:
+    struct Node {
+        size_t lo, hi; // Range of points
+        size_t left, right; // Child nodes, 0 for a leaf
+    };
+
+    vector<Fr> points;
+    vector<Node> nodes; // nodes[0] is the root
+    vector<PolynomialDivisor> divisors; // divisors[k] divides by the M(x) of nodes[k]
+    vector<Fr> weights; // 1 / Z'(x_j), filled by the first interpolate()
+
+    size_t build(size_t lo, size_t hi);
+    void evaluateNode(size_t k, PolyView remainder, vector<Fr> &out);
+    vector<Fr> combineNode(size_t k, const vector<Fr> &c);
+};
+
+#endif // MULTIPOINT_H
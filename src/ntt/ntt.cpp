@@ -1,6 +1,21 @@
+#include "ntt.h"
+#include "../parallel/parallel.h"
+#include "../profile/profile.h"
 #include <mcl/bn.hpp>
 #include <iostream>
 #include <cmath>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define NTT_X86_KERNELS
+#include <immintrin.h>
+#endif
 
 using namespace mcl;
 using namespace bn;
@@ -15,57 +30,875 @@ size_t bitReverse(size_t x, size_t logN) {
     return res;
 }
 
+// Largest 2-adic order we ever look for, far above any field we use
+static const size_t MAX_TWO_ADICITY = 64;
+
+static vector<Fr> buildRootTable() {
+    vector<Fr> roots(2);
+    roots[0] = 1;
+    roots[1] = -1;
+
+    Fr root;
+    while (roots.size() < MAX_TWO_ADICITY && Fr::squareRoot(root, roots.back())) {
+        roots.push_back(root);
+    }
+    return roots;
+}
+
+Fr rootOfUnity(size_t logN) {
+    static const vector<Fr> roots = buildRootTable();
+    if (logN >= roots.size()) throw runtime_error("No root of unity of this order in Fr.");
+    return roots[logN];
+}
+
 Fr findPrimitiveRoot(size_t N) {
-    Fr order = -1;
+    size_t logN = 1;
+    while (((size_t)1 << logN) < N) logN++;
+    return rootOfUnity(logN);
+}
 
-    size_t i = 1;
-    while (i < N / 2) {
-        i *= 2;
-        Fr::squareRoot(order, order);
+EvaluationDomain::EvaluationDomain(size_t logN, Fr omega)
+    : logN(logN), size((size_t)1 << logN), omega(omega) {
+    PROFILE_COUNT(FieldInversion, 2);
+    Fr::inv(omega_inv, omega);
+    Fr::inv(n_inv, Fr(size));
+}
+
+void EvaluationDomain::buildTables() const {
+    rev_table.resize(size);
+    for (size_t i = 0; i < size; i++) rev_table[i] = bitReverse(i, logN);
+
+    twiddle_table.resize(size - 1);
+    twiddle_inv_table.resize(size - 1);
+    for (size_t half = 1; half < size; half <<= 1) {
+        Fr wlen, wlen_inv;
+        Fr::pow(wlen, omega, size / (2 * half));
+        Fr::pow(wlen_inv, omega_inv, size / (2 * half));
+
+        Fr w = 1, w_inv = 1;
+        for (size_t j = 0; j < half; j++) {
+            twiddle_table[half - 1 + j] = w;
+            twiddle_inv_table[half - 1 + j] = w_inv;
+            w *= wlen;
+            w_inv *= wlen_inv;
+        }
     }
+}
 
-    return order;
+const vector<uint32_t> &EvaluationDomain::bitReversal() const {
+    call_once(tables_once, [this] { buildTables(); });
+    return rev_table;
 }
 
-void ntt_transform(vector<Fr> &A, Fr omega) {
-    size_t n = A.size();
-    size_t logN = log2(n);
-    assert((1 << logN) == n); // n must be power of 2
+const vector<Fr> &EvaluationDomain::twiddles(bool inverse) const {
+    call_once(tables_once, [this] { buildTables(); });
+    return inverse ? twiddle_inv_table : twiddle_table;
+}
 
-    for (size_t i = 0; i < n; ++i) {
-        size_t j = bitReverse(i, logN);
-        if (i < j) swap(A[i], A[j]);
+const EvaluationDomain &EvaluationDomain::get(size_t logN) {
+    static mutex lock;
+    static unique_ptr<EvaluationDomain> domains[MAX_TWO_ADICITY];
+    if (logN >= MAX_TWO_ADICITY) throw runtime_error("No root of unity of this order in Fr.");
+
+    lock_guard<mutex> guard(lock);
+    if (!domains[logN]) domains[logN].reset(new EvaluationDomain(logN, rootOfUnity(logN)));
+    return *domains[logN];
+}
+
+// Below this size a transform is not worth splitting across threads
+static const size_t NTT_PARALLEL_THRESHOLD = 1 << 12;
+
+// Butterflies (a[j], b[j]) <- (a[j] + w[j] b[j], a[j] - w[j] b[j]) for j < count,
+// written with mcl's operators and a temporary per result
+static void spanGeneric(Fr *a, Fr *b, const Fr *w, size_t count) {
+    for (size_t j = 0; j < count; ++j) {
+        Fr u = a[j];
+        Fr v = b[j] * w[j];
+        a[j] = u + v;
+        b[j] = u - v;
+    }
+}
+
+// Same butterflies through the in-place static Montgomery routines, skipping
+// the multiplication by a leading unit twiddle and interleaving two
+// independent butterflies per iteration
+static void spanUnrolled(Fr *a, Fr *b, const Fr *w, size_t count) {
+    size_t j = 0;
+    Fr v0, v1;
+
+    if (count > 0 && w[0].isOne()) {
+        v0 = b[0];
+        Fr::sub(b[0], a[0], v0);
+        Fr::add(a[0], a[0], v0);
+        j = 1;
+    }
+
+    for (; j + 1 < count; j += 2) {
+        Fr::mul(v0, b[j], w[j]);
+        Fr::mul(v1, b[j + 1], w[j + 1]);
+        Fr::sub(b[j], a[j], v0);
+        Fr::sub(b[j + 1], a[j + 1], v1);
+        Fr::add(a[j], a[j], v0);
+        Fr::add(a[j + 1], a[j + 1], v1);
+    }
+
+    if (j < count) {
+        Fr::mul(v0, b[j], w[j]);
+        Fr::sub(b[j], a[j], v0);
+        Fr::add(a[j], a[j], v0);
+    }
+}
+
+typedef void (*ButterflySpan)(Fr *, Fr *, const Fr *, size_t);
+
+#ifdef NTT_X86_KERNELS
+
+// The SIMD kernels work on the raw Montgomery limbs of Fr. They run only when
+// Fr is a 4-limb Montgomery field below 2^254, as for BN_SNARK1, and only after
+// a self-test against spanUnrolled() passes.
+static const size_t FR_LIMBS = 4;
+
+// Modulus split into the limb widths of the kernels, with -p^-1 mod 2^width
+struct LimbField {
+    bool usable;
+    uint64_t p29[9], pinv29; // AVX2: 9 limbs of 29 bits, products fit 32x32-bit multiplies
+    uint64_t p52[5], pinv52; // AVX-512 IFMA: 5 limbs of 52 bits
+};
+
+// Bits [start, start + width) of a 4-limb integer
+static uint64_t limbBits(const uint64_t *x, size_t start, size_t width) {
+    size_t word = start / 64, shift = start % 64;
+    uint64_t bits = word < FR_LIMBS ? x[word] >> shift : 0;
+    if (shift != 0 && word + 1 < FR_LIMBS) bits |= x[word + 1] << (64 - shift);
+    return bits & ((1ULL << width) - 1);
+}
+
+static LimbField makeLimbField() {
+    LimbField field;
+    memset(&field, 0, sizeof(field));
+
+    const fp::Op &op = Fr::getOp();
+    field.usable = op.isMont && op.N == FR_LIMBS && sizeof(Fr) >= FR_LIMBS * sizeof(uint64_t) &&
+        sizeof(Fr) % sizeof(uint64_t) == 0 && (op.p[FR_LIMBS - 1] >> 62) == 0;
+    if (!field.usable) return field;
+
+    const uint64_t *p = reinterpret_cast<const uint64_t *>(op.p);
+    for (size_t k = 0; k < 9; k++) field.p29[k] = limbBits(p, 29 * k, 29);
+    for (size_t k = 0; k < 5; k++) field.p52[k] = limbBits(p, 52 * k, 52);
+
+    // Newton iteration doubles the correct low bits of p^-1 each step
+    uint64_t inv = p[0];
+    for (int i = 0; i < 6; i++) inv *= 2 - p[0] * inv;
+    field.pinv29 = (0 - inv) & ((1ULL << 29) - 1);
+    field.pinv52 = (0 - inv) & ((1ULL << 52) - 1);
+    return field;
+}
+
+static const LimbField &limbField() {
+    static const LimbField field = makeLimbField();
+    return field;
+}
+
+#define NTT_TARGET_AVX2 __attribute__((target("avx2")))
+#define NTT_TARGET_IFMA __attribute__((target("avx512f,avx512ifma")))
+
+// Logical shifts by any count, 64 and above give 0
+NTT_TARGET_AVX2 static inline __m256i shiftLeft(__m256i x, int count) {
+    return _mm256_sll_epi64(x, _mm_cvtsi32_si128(count));
+}
+
+NTT_TARGET_AVX2 static inline __m256i shiftRight(__m256i x, int count) {
+    return _mm256_srl_epi64(x, _mm_cvtsi32_si128(count));
+}
+
+// Swaps rows and columns of a 4 x 4 matrix of 64-bit words
+NTT_TARGET_AVX2 static inline void transpose4(__m256i r[4]) {
+    __m256i t0 = _mm256_unpacklo_epi64(r[0], r[1]), t1 = _mm256_unpackhi_epi64(r[0], r[1]);
+    __m256i t2 = _mm256_unpacklo_epi64(r[2], r[3]), t3 = _mm256_unpackhi_epi64(r[2], r[3]);
+    r[0] = _mm256_permute2x128_si256(t0, t2, 0x20);
+    r[1] = _mm256_permute2x128_si256(t1, t3, 0x20);
+    r[2] = _mm256_permute2x128_si256(t0, t2, 0x31);
+    r[3] = _mm256_permute2x128_si256(t1, t3, 0x31);
+}
+
+// Four elements as 29-bit limbs, lane k holding x[k] times 2^scale
+NTT_TARGET_AVX2 static inline void loadLimbs29(__m256i l[9], const Fr *x, int scale) {
+    __m256i words[4];
+    for (int k = 0; k < 4; k++) words[k] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&x[k]));
+    transpose4(words);
+
+    __m256i mask = _mm256_set1_epi64x((1LL << 29) - 1);
+    for (int k = 0; k < 9; k++) {
+        int start = 29 * k - scale;
+        int word = start < 0 ? -1 : start / 64, shift = start - 64 * word;
+        __m256i bits = word >= 0 ? shiftRight(words[word], shift) : _mm256_setzero_si256();
+        if (word + 1 < 4) bits = _mm256_or_si256(bits, shiftLeft(words[word + 1], 64 - shift));
+        l[k] = _mm256_and_si256(bits, mask);
+    }
+}
+
+// Inverse of loadLimbs29() without scaling, limbs must be reduced
+NTT_TARGET_AVX2 static inline void storeLimbs29(Fr *x, const __m256i l[9]) {
+    __m256i words[4];
+    for (int w = 0; w < 4; w++) {
+        words[w] = _mm256_setzero_si256();
+        for (int k = 0; k < 9; k++) {
+            int pos = 29 * k - 64 * w;
+            if (pos <= -29 || pos >= 64) continue;
+            words[w] = _mm256_or_si256(words[w], pos >= 0 ? shiftLeft(l[k], pos) : shiftRight(l[k], -pos));
+        }
+    }
+
+    transpose4(words);
+    for (int k = 0; k < 4; k++) _mm256_storeu_si256(reinterpret_cast<__m256i *>(&x[k]), words[k]);
+}
+
+// r = a b 2^-261 mod p in each of 4 lanes, reduced below p when a b < 2^261 p.
+// Products of 29-bit limbs are below 2^58 and a column collects at most 18 of
+// them, so the columns are carried only once at the end.
+NTT_TARGET_AVX2 static void montMul29(__m256i r[9], const __m256i a[9], const __m256i b[9], const LimbField &field) {
+    __m256i mask = _mm256_set1_epi64x((1LL << 29) - 1), pinv = _mm256_set1_epi64x(field.pinv29);
+    __m256i p[9], t[9];
+    for (int j = 0; j < 9; j++) {
+        p[j] = _mm256_set1_epi64x(field.p29[j]);
+        t[j] = _mm256_setzero_si256();
+    }
+
+    for (int i = 0; i < 9; i++) {
+        for (int j = 0; j < 9; j++) t[j] = _mm256_add_epi64(t[j], _mm256_mul_epu32(a[i], b[j]));
+
+        // m p clears the low limb, which then carries into the next one
+        __m256i m = _mm256_and_si256(_mm256_mul_epu32(t[0], pinv), mask);
+        for (int j = 0; j < 9; j++) t[j] = _mm256_add_epi64(t[j], _mm256_mul_epu32(m, p[j]));
+
+        __m256i carry = _mm256_srli_epi64(t[0], 29);
+        for (int j = 0; j < 8; j++) t[j] = t[j + 1];
+        t[0] = _mm256_add_epi64(t[0], carry);
+        t[8] = _mm256_setzero_si256();
+    }
+
+    for (int j = 0; j < 8; j++) {
+        t[j + 1] = _mm256_add_epi64(t[j + 1], _mm256_srli_epi64(t[j], 29));
+        t[j] = _mm256_and_si256(t[j], mask);
+    }
+
+    // t < 2p, keep t - p unless it borrows. Each limb is biased by 2^29 so the
+    // borrow shows up as a clear bit 29.
+    __m256i one = _mm256_set1_epi64x(1), bias = _mm256_set1_epi64x(1LL << 29), borrow = _mm256_setzero_si256();
+    __m256i d[9];
+    for (int j = 0; j < 9; j++) {
+        d[j] = _mm256_sub_epi64(_mm256_sub_epi64(_mm256_add_epi64(t[j], bias), p[j]), borrow);
+        borrow = _mm256_xor_si256(_mm256_srli_epi64(d[j], 29), one);
+        d[j] = _mm256_and_si256(d[j], mask);
+    }
+    __m256i keep = _mm256_cmpeq_epi64(borrow, one);
+    for (int j = 0; j < 9; j++) r[j] = _mm256_blendv_epi8(d[j], t[j], keep);
+}
+
+// Multiplies four butterflies at a time. b is scaled by 2^5 on load, so the
+// 2^261 radix of the 29-bit limbs gives b w in mcl's 2^256 Montgomery form.
+NTT_TARGET_AVX2 static void spanAvx2(Fr *a, Fr *b, const Fr *w, size_t count) {
+    const LimbField &field = limbField();
+    __m256i x[9], y[9], v[9];
+    Fr products[4];
+
+    size_t j = 0;
+    for (; j + 4 <= count; j += 4) {
+        loadLimbs29(x, b + j, 5);
+        loadLimbs29(y, w + j, 0);
+        montMul29(v, x, y, field);
+        storeLimbs29(products, v);
+
+        for (size_t k = 0; k < 4; k++) {
+            Fr::sub(b[j + k], a[j + k], products[k]);
+            Fr::add(a[j + k], a[j + k], products[k]);
+        }
+    }
+    spanUnrolled(a + j, b + j, w + j, count - j);
+}
+
+// GCC's AVX-512 headers start some intrinsics from _mm512_undefined_epi32(),
+// which its own -Wmaybe-uninitialized flags
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+// Word offsets of eight consecutive elements, for gathers and scatters
+NTT_TARGET_IFMA static inline __m512i elementOffsets() {
+    const long long stride = sizeof(Fr) / sizeof(uint64_t);
+    return _mm512_set_epi64(7 * stride, 6 * stride, 5 * stride, 4 * stride, 3 * stride, 2 * stride, stride, 0);
+}
+
+// Eight elements as 52-bit limbs, lane k holding x[k] times 2^scale
+NTT_TARGET_IFMA static inline void loadLimbs52(__m512i l[5], const Fr *x, int scale) {
+    const long long *base = reinterpret_cast<const long long *>(x);
+    __m512i offsets = elementOffsets(), words[4];
+    for (int w = 0; w < 4; w++) words[w] = _mm512_i64gather_epi64(offsets, base + w, 8);
+
+    __m512i mask = _mm512_set1_epi64((1LL << 52) - 1);
+    for (int k = 0; k < 5; k++) {
+        int start = 52 * k - scale;
+        int word = start < 0 ? -1 : start / 64, shift = start - 64 * word;
+        __m512i bits = word >= 0 ? _mm512_srl_epi64(words[word], _mm_cvtsi32_si128(shift)) : _mm512_setzero_si512();
+        if (word + 1 < 4) bits = _mm512_or_si512(bits, _mm512_sll_epi64(words[word + 1], _mm_cvtsi32_si128(64 - shift)));
+        l[k] = _mm512_and_si512(bits, mask);
+    }
+}
+
+// Inverse of loadLimbs52() without scaling, limbs must be reduced
+NTT_TARGET_IFMA static inline void storeLimbs52(Fr *x, const __m512i l[5]) {
+    long long *base = reinterpret_cast<long long *>(x);
+    __m512i offsets = elementOffsets();
+    for (int w = 0; w < 4; w++) {
+        __m512i word = _mm512_setzero_si512();
+        for (int k = 0; k < 5; k++) {
+            int pos = 52 * k - 64 * w;
+            if (pos <= -52 || pos >= 64) continue;
+            word = _mm512_or_si512(word, pos >= 0 ? _mm512_sll_epi64(l[k], _mm_cvtsi32_si128(pos)) : _mm512_srl_epi64(l[k], _mm_cvtsi32_si128(-pos)));
+        }
+        _mm512_i64scatter_epi64(base + w, offsets, word, 8);
+    }
+}
+
+// r = a b 2^-260 mod p in each of 8 lanes, reduced below p when a b < 2^260 p.
+// The IFMA instructions add the low and high 52 bits of each limb product.
+NTT_TARGET_IFMA static void montMul52(__m512i r[5], const __m512i a[5], const __m512i b[5], const LimbField &field) {
+    __m512i mask = _mm512_set1_epi64((1LL << 52) - 1), pinv = _mm512_set1_epi64(field.pinv52), zero = _mm512_setzero_si512();
+    __m512i p[5], t[6];
+    for (int j = 0; j < 5; j++) p[j] = _mm512_set1_epi64(field.p52[j]);
+    for (int j = 0; j < 6; j++) t[j] = zero;
+
+    for (int i = 0; i < 5; i++) {
+        for (int j = 0; j < 5; j++) {
+            t[j] = _mm512_madd52lo_epu64(t[j], a[i], b[j]);
+            t[j + 1] = _mm512_madd52hi_epu64(t[j + 1], a[i], b[j]);
+        }
+
+        __m512i m = _mm512_madd52lo_epu64(zero, t[0], pinv);
+        for (int j = 0; j < 5; j++) {
+            t[j] = _mm512_madd52lo_epu64(t[j], m, p[j]);
+            t[j + 1] = _mm512_madd52hi_epu64(t[j + 1], m, p[j]);
+        }
+
+        __m512i carry = _mm512_srli_epi64(t[0], 52);
+        for (int j = 0; j < 5; j++) t[j] = t[j + 1];
+        t[0] = _mm512_add_epi64(t[0], carry);
+        t[5] = zero;
+    }
+
+    for (int j = 0; j < 4; j++) {
+        t[j + 1] = _mm512_add_epi64(t[j + 1], _mm512_srli_epi64(t[j], 52));
+        t[j] = _mm512_and_si512(t[j], mask);
+    }
+
+    // Same biased subtraction as montMul29()
+    __m512i one = _mm512_set1_epi64(1), bias = _mm512_set1_epi64(1LL << 52), borrow = zero;
+    __m512i d[5];
+    for (int j = 0; j < 5; j++) {
+        d[j] = _mm512_sub_epi64(_mm512_sub_epi64(_mm512_add_epi64(t[j], bias), p[j]), borrow);
+        borrow = _mm512_xor_si512(_mm512_srli_epi64(d[j], 52), one);
+        d[j] = _mm512_and_si512(d[j], mask);
+    }
+    __mmask8 keep = _mm512_cmpeq_epi64_mask(borrow, one);
+    for (int j = 0; j < 5; j++) r[j] = _mm512_mask_blend_epi64(keep, d[j], t[j]);
+}
+
+// Multiplies eight butterflies at a time, b is scaled by 2^4 for the 2^260 radix
+NTT_TARGET_IFMA static void spanAvx512Ifma(Fr *a, Fr *b, const Fr *w, size_t count) {
+    const LimbField &field = limbField();
+    __m512i x[5], y[5], v[5];
+    Fr products[8];
+
+    size_t j = 0;
+    for (; j + 8 <= count; j += 8) {
+        loadLimbs52(x, b + j, 4);
+        loadLimbs52(y, w + j, 0);
+        montMul52(v, x, y, field);
+        storeLimbs52(products, v);
+
+        for (size_t k = 0; k < 8; k++) {
+            Fr::sub(b[j + k], a[j + k], products[k]);
+            Fr::add(a[j + k], a[j + k], products[k]);
+        }
+    }
+    spanUnrolled(a + j, b + j, w + j, count - j);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif
+
+// Random butterflies through span must match spanUnrolled() exactly
+static bool spanAgrees(ButterflySpan span) {
+    const size_t count = 64;
+    vector<Fr> a(count), b(count), w(count);
+    for (size_t j = 0; j < count; j++) {
+        a[j].setByCSPRNG();
+        b[j].setByCSPRNG();
+        w[j].setByCSPRNG();
+    }
+
+    vector<Fr> a_ref = a, b_ref = b;
+    span(a.data(), b.data(), w.data(), count);
+    spanUnrolled(a_ref.data(), b_ref.data(), w.data(), count);
+    return a == a_ref && b == b_ref;
+}
+
+static ButterflySpan kernelSpan(NttKernel kernel) {
+    switch (kernel) {
+        case NttKernel::Generic: return spanGeneric;
+        case NttKernel::Unrolled: return spanUnrolled;
+#ifdef NTT_X86_KERNELS
+        case NttKernel::Avx2: return spanAvx2;
+        case NttKernel::Avx512Ifma: return spanAvx512Ifma;
+#endif
+        default: return nullptr;
+    }
+}
+
+// CPU and field support, checked once per kernel
+static bool detectKernel(NttKernel kernel) {
+#ifdef NTT_X86_KERNELS
+    if (kernel == NttKernel::Avx2) {
+        return __builtin_cpu_supports("avx2") && limbField().usable && spanAgrees(spanAvx2);
+    }
+    if (kernel == NttKernel::Avx512Ifma) {
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512ifma") &&
+            limbField().usable && spanAgrees(spanAvx512Ifma);
+    }
+#endif
+    return kernel == NttKernel::Auto || kernel == NttKernel::Generic || kernel == NttKernel::Unrolled;
+}
+
+bool nttKernelSupported(NttKernel kernel) {
+    static const bool avx2 = detectKernel(NttKernel::Avx2);
+    static const bool avx512_ifma = detectKernel(NttKernel::Avx512Ifma);
+    if (kernel == NttKernel::Avx2) return avx2;
+    if (kernel == NttKernel::Avx512Ifma) return avx512_ifma;
+    return detectKernel(kernel);
+}
+
+// Times every supported kernel on the same batch of butterflies, best of a few runs
+static ButterflySpan fastestSpan() {
+    const size_t count = 1 << 10;
+    vector<Fr> a(count), b(count), w(count);
+    for (size_t j = 0; j < count; j++) {
+        a[j].setByCSPRNG();
+        b[j].setByCSPRNG();
+        w[j].setByCSPRNG();
+    }
+
+    ButterflySpan best = spanUnrolled;
+    double best_time = INFINITY;
+    for (NttKernel kernel : {NttKernel::Unrolled, NttKernel::Avx2, NttKernel::Avx512Ifma}) {
+        if (!nttKernelSupported(kernel)) continue;
+
+        ButterflySpan span = kernelSpan(kernel);
+        for (int run = 0; run < 3; run++) {
+            auto start = chrono::steady_clock::now();
+            span(a.data(), b.data(), w.data(), count);
+            double time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if (time < best_time) {
+                best_time = time;
+                best = span;
+            }
+        }
     }
+    return best;
+}
+
+static atomic<int> kernel_choice(static_cast<int>(NttKernel::Auto));
+
+static ButterflySpan activeSpan() {
+    NttKernel kernel = static_cast<NttKernel>(kernel_choice.load());
+    if (kernel != NttKernel::Auto) return kernelSpan(kernel);
+
+    static const ButterflySpan fastest = fastestSpan();
+    return fastest;
+}
+
+void setNttKernel(NttKernel kernel) {
+    if (!nttKernelSupported(kernel)) throw runtime_error("NTT kernel is not supported on this CPU or field.");
+    kernel_choice.store(static_cast<int>(kernel));
+}
+
+const char *nttKernelName() {
+    ButterflySpan span = activeSpan();
+    if (span == spanGeneric) return "generic";
+    if (span == spanUnrolled) return "unrolled";
+#ifdef NTT_X86_KERNELS
+    if (span == spanAvx2) return "avx2";
+    if (span == spanAvx512Ifma) return "avx512-ifma";
+#endif
+    return "unknown";
+}
+
+// Radix-2 stages with half-length in [half_begin, half_end) on A[0, len)
+static void stages(Fr *A, size_t len, const vector<Fr> &tw, size_t half_begin, size_t half_end, ButterflySpan span) {
+    for (size_t half = half_begin; half < half_end; half <<= 1) {
+        const Fr *w = &tw[half - 1];
+        for (size_t i = 0; i < len; i += 2 * half) {
+            span(A + i, A + i + half, w, half);
+        }
+    }
+}
+
+// Bit-reversal followed by the radix-2 stages, tw laid out as in EvaluationDomain.
+// Large inputs first transform 2^k independent blocks in parallel, then split
+// each of the remaining wide stages by butterfly. Field arithmetic is exact,
+// so the result does not depend on the thread count.
+static void butterflies(Fr *A, size_t n, const vector<uint32_t> &rev, const vector<Fr> &tw) {
+    size_t threads = getThreadCount();
+    ButterflySpan span = activeSpan();
+
+    if (n < NTT_PARALLEL_THRESHOLD || threads == 1) {
+        for (size_t i = 0; i < n; ++i) {
+            size_t j = rev[i];
+            if (i < j) swap(A[i], A[j]);
+        }
+        stages(A, n, tw, 1, n, span);
+        return;
+    }
+
+    // Each pair is swapped exactly once, by its smaller index
+    parallelFor(n, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; ++i) {
+            size_t j = rev[i];
+            if (i < j) swap(A[i], A[j]);
+        }
+    }, threads, 1024);
+
+    // Stages shorter than a block stay inside it
+    size_t blocks = 1;
+    while (blocks < 4 * threads && blocks < n / 2) blocks <<= 1;
+    size_t block = n / blocks;
+
+    parallelFor(blocks, [&](size_t begin, size_t end, size_t) {
+        for (size_t b = begin; b < end; b++) stages(&A[b * block], block, tw, 1, block, span);
+    }, threads);
+
+    size_t logHalf = log2(block);
+    for (size_t half = block; half < n; half <<= 1, logHalf++) {
+        const Fr *w = &tw[half - 1];
+        parallelFor(n / 2, [&](size_t begin, size_t end, size_t) {
+            // Cut the chunk at block boundaries so each piece is one contiguous span
+            for (size_t b = begin; b < end;) {
+                size_t i = ((b >> logHalf) << (logHalf + 1)), j = b & (half - 1);
+                size_t count = min(end - b, half - j);
+                span(A + i + j, A + i + j + half, w + j, count);
+                b += count;
+            }
+        }, threads, 1024);
+    }
+}
+
+// Side of the square tiles used by the blocked transposes
+static const size_t TRANSPOSE_TILE = 16;
+
+// dst[c * rows + r] = src[r * cols + c], tile rows split across threads
+static void transpose(Fr *dst, const Fr *src, size_t rows, size_t cols) {
+    size_t tiles = (rows + TRANSPOSE_TILE - 1) / TRANSPOSE_TILE;
+
+    parallelFor(tiles, [&](size_t begin, size_t end, size_t) {
+        for (size_t t = begin; t < end; t++) {
+            size_t r0 = t * TRANSPOSE_TILE, r1 = min(rows, r0 + TRANSPOSE_TILE);
+            for (size_t c0 = 0; c0 < cols; c0 += TRANSPOSE_TILE) {
+                size_t c1 = min(cols, c0 + TRANSPOSE_TILE);
+                for (size_t r = r0; r < r1; r++) {
+                    for (size_t c = c0; c < c1; c++) dst[c * rows + r] = src[r * cols + c];
+                }
+            }
+        }
+    });
+}
 
-    for (size_t len = 2; len <= n; len <<= 1) {
-        Fr wlen;
-        Fr::pow(wlen, omega, n / len);
+// Six-step form of the four-step (Bailey) NTT. With n = n1 * n2, the input is
+// an n2 x n1 row-major matrix. Its columns get size-n2 NTTs, each entry (j1, k2)
+// is scaled by w^(j1 k2), then the rows get size-n1 NTTs. Transposes keep every
+// sub-transform contiguous, so each one fits in cache. The sub-transforms
+// scale by 1/n2 and 1/n1 when inverse, which multiply to 1/n.
+static void fourStep(vector<Fr> &A, const EvaluationDomain &domain, bool inverse) {
+    size_t log1 = domain.logN / 2, log2n = domain.logN - log1;
+    size_t n1 = (size_t)1 << log1, n2 = (size_t)1 << log2n;
+    const EvaluationDomain &sub1 = EvaluationDomain::get(log1);
+    const EvaluationDomain &sub2 = EvaluationDomain::get(log2n);
+    Fr root = inverse ? domain.omega_inv : domain.omega;
+
+    vector<Fr> T(domain.size);
+    transpose(T.data(), A.data(), n2, n1);
+
+    // Size-n2 NTT of every row j1 of T, then the w^(j1 k2) twiddle
+    parallelFor(n1, [&](size_t begin, size_t end, size_t) {
+        Fr step;
+        Fr::pow(step, root, begin);
+        for (size_t j1 = begin; j1 < end; j1++) {
+            Fr *row = &T[j1 * n2];
+            butterflies(row, n2, sub2.bitReversal(), sub2.twiddles(inverse));
 
-        for (size_t i = 0; i < n; i += len) {
             Fr w = 1;
-            for (size_t j = 0; j < len / 2; ++j) {
-                Fr u = A[i + j];
-                Fr v = A[i + j + len / 2] * w;
-                A[i + j] = u + v;
-                A[i + j + len / 2] = u - v;
-                w *= wlen;
+            for (size_t k2 = 0; k2 < n2; k2++) {
+                row[k2] *= inverse ? w * sub2.n_inv : w;
+                w *= step;
+            }
+            step *= root;
+        }
+    });
+
+    transpose(A.data(), T.data(), n1, n2);
+
+    // Size-n1 NTT of every row k2, giving X[k2 + n2 k1] at A[k2 * n1 + k1]
+    parallelFor(n2, [&](size_t begin, size_t end, size_t) {
+        for (size_t k2 = begin; k2 < end; k2++) {
+            Fr *row = &A[k2 * n1];
+            butterflies(row, n1, sub1.bitReversal(), sub1.twiddles(inverse));
+            if (inverse) {
+                for (size_t k1 = 0; k1 < n1; k1++) row[k1] *= sub1.n_inv;
             }
         }
+    });
+
+    transpose(T.data(), A.data(), n2, n1);
+    A.swap(T);
+}
+
+// Canonical domains at least this large use the four-step NTT
+static const size_t FOUR_STEP_THRESHOLD = 1 << 20;
+
+// Sub-transforms come from the cached domains, so only the canonical root qualifies
+static bool useFourStep(const EvaluationDomain &domain) {
+    return domain.size >= FOUR_STEP_THRESHOLD && domain.omega == rootOfUnity(domain.logN);
+}
+
+void EvaluationDomain::ntt(vector<Fr> &A) const {
+    assert(A.size() == size);
+    PROFILE_NTT(size, 1);
+    if (useFourStep(*this)) {
+        fourStep(A, *this, false);
+        return;
     }
+    butterflies(A.data(), size, bitReversal(), twiddles());
+}
+
+void EvaluationDomain::intt(vector<Fr> &A) const {
+    assert(A.size() == size);
+    PROFILE_NTT(size, 1);
+    if (useFourStep(*this)) {
+        fourStep(A, *this, true);
+        return;
+    }
+    butterflies(A.data(), size, bitReversal(), twiddles(true));
+
+    parallelFor(size, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; i++) A[i] *= n_inv;
+    }, 0, NTT_PARALLEL_THRESHOLD);
+}
+
+void EvaluationDomain::nttFourStep(vector<Fr> &A) const {
+    assert(A.size() == size && logN >= 2 && omega == rootOfUnity(logN));
+    PROFILE_NTT(size, 1);
+    fourStep(A, *this, false);
+}
+
+void EvaluationDomain::inttFourStep(vector<Fr> &A) const {
+    assert(A.size() == size && logN >= 2 && omega == rootOfUnity(logN));
+    PROFILE_NTT(size, 1);
+    fourStep(A, *this, true);
+}
+
+// Cached domain when omega is the canonical root for n, else null
+static const EvaluationDomain *canonicalDomain(size_t logN, const Fr &omega) {
+    if (logN == 0 || logN >= MAX_TWO_ADICITY) return nullptr;
+    const EvaluationDomain &domain = EvaluationDomain::get(logN);
+    return domain.omega == omega ? &domain : nullptr;
+}
+
+// Domain for n = 2^logN points generated by omega. The cached one is used for
+// the canonical root, otherwise a temporary domain is built and kept in owned.
+static const EvaluationDomain &domainFor(size_t n, const Fr &omega, unique_ptr<EvaluationDomain> &owned) {
+    size_t logN = log2(n);
+    assert(((size_t)1 << logN) == n); // n must be power of 2
+
+    const EvaluationDomain *cached = canonicalDomain(logN, omega);
+    if (cached) return *cached;
+
+    owned.reset(new EvaluationDomain(logN, omega));
+    return *owned;
+}
+
+void ntt_transform(vector<Fr> &A, Fr omega) {
+    unique_ptr<EvaluationDomain> owned;
+    domainFor(A.size(), omega, owned).ntt(A);
 }
 
 void ntt_inverse(vector<Fr> &A, Fr omega) {
-    size_t n = A.size();
+    unique_ptr<EvaluationDomain> owned;
+    domainFor(A.size(), omega, owned).intt(A);
+}
 
-    Fr omega_inv;
-    Fr::inv(omega_inv, omega);
-    ntt_transform(A, omega_inv);
+// Transforms every polynomial of the batch with one shared domain. Batches at
+// least as large as the thread count are split by polynomial, each transform
+// then runs serially. Smaller batches parallelize inside each transform.
+static void batch(vector<vector<Fr>> &polys, const Fr &omega, bool inverse) {
+    if (polys.empty()) return;
+
+    size_t n = polys[0].size();
+    for (const auto &p : polys) assert(p.size() == n); // all polynomials must have equal length
+
+    unique_ptr<EvaluationDomain> owned;
+    const EvaluationDomain &domain = domainFor(n, omega, owned);
+
+    auto run = [&](size_t begin, size_t end, size_t) {
+        for (size_t p = begin; p < end; p++) {
+            if (inverse) domain.intt(polys[p]);
+            else domain.ntt(polys[p]);
+        }
+    };
+
+    if (polys.size() >= getThreadCount()) parallelFor(polys.size(), run);
+    else run(0, polys.size(), 0);
+}
+
+void ntt_transform_batch(vector<vector<Fr>> &polys, Fr omega) {
+    batch(polys, omega, false);
+}
 
-    Fr n_inv;
-    Fr::inv(n_inv, n);
-    for (auto &x : A) {
-        x *= n_inv;
+void ntt_inverse_batch(vector<vector<Fr>> &polys, Fr omega) {
+    batch(polys, omega, true);
+}
+
+// NTT of count interleaved polynomials, A[i * count + p] is entry i of polynomial p.
+// Every butterfly moves two rows of count elements under one twiddle, so each
+// twiddle is loaded once for the whole batch. Rows of a stage are split across threads.
+static void interleaved(vector<Fr> &A, size_t count, const Fr &omega, bool inverse) {
+    if (count == 0) return;
+    assert(A.size() % count == 0);
+
+    size_t n = A.size() / count;
+    unique_ptr<EvaluationDomain> owned;
+    const EvaluationDomain &domain = domainFor(n, omega, owned);
+    const vector<Fr> &tw = domain.twiddles(inverse);
+    const vector<uint32_t> &rev = domain.bitReversal();
+    size_t grain = max((size_t)1, NTT_PARALLEL_THRESHOLD / count);
+    PROFILE_NTT(n, count);
+
+    parallelFor(n, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; ++i) {
+            size_t j = rev[i];
+            if (i < j) swap_ranges(&A[i * count], &A[i * count] + count, &A[j * count]);
+        }
+    }, 0, grain);
+
+    for (size_t half = 1, logHalf = 0; half < n; half <<= 1, logHalf++) {
+        const Fr *w = &tw[half - 1];
+        parallelFor(n / 2, [&](size_t begin, size_t end, size_t) {
+            Fr v;
+            for (size_t b = begin; b < end; b++) {
+                size_t i = ((b >> logHalf) << (logHalf + 1)), j = b & (half - 1);
+                Fr *x = &A[(i + j) * count], *y = &A[(i + j + half) * count];
+                const Fr &wj = w[j];
+                for (size_t p = 0; p < count; p++) {
+                    Fr::mul(v, y[p], wj);
+                    Fr::sub(y[p], x[p], v);
+                    Fr::add(x[p], x[p], v);
+                }
+            }
+        }, 0, grain);
     }
+
+    if (inverse) {
+        parallelFor(A.size(), [&](size_t begin, size_t end, size_t) {
+            for (size_t i = begin; i < end; i++) A[i] *= domain.n_inv;
+        }, 0, NTT_PARALLEL_THRESHOLD);
+    }
+}
+
+void ntt_transform_interleaved(vector<Fr> &A, size_t count, Fr omega) {
+    interleaved(A, count, omega, false);
+}
+
+void ntt_inverse_interleaved(vector<Fr> &A, size_t count, Fr omega) {
+    interleaved(A, count, omega, true);
+}
+
+Fr cosetShift() {
+    return Fr(5);
+}
+
+// A[j] *= factor^j, each chunk starts from factor^begin
+static void scaleByPowers(vector<Fr> &A, const Fr &factor) {
+    parallelFor(A.size(), [&](size_t begin, size_t end, size_t) {
+        Fr power;
+        Fr::pow(power, factor, begin);
+        for (size_t j = begin; j < end; j++) {
+            A[j] *= power;
+            power *= factor;
+        }
+    }, 0, NTT_PARALLEL_THRESHOLD);
+}
+
+void coset_ntt(vector<Fr> &A, Fr omega, Fr shift) {
+    scaleByPowers(A, shift);
+    ntt_transform(A, omega);
+}
+
+void coset_intt(vector<Fr> &A, Fr omega, Fr shift) {
+    ntt_inverse(A, omega);
+
+    Fr shift_inv;
+    PROFILE_COUNT(FieldInversion, 1);
+    Fr::inv(shift_inv, shift);
+    scaleByPowers(A, shift_inv);
+}
+
+vector<Fr> low_degree_extension(const vector<Fr> &evals, size_t k, Fr shift) {
+    size_t n = evals.size();
+    assert(k > 0 && (k & (k - 1)) == 0); // k must be power of 2
+
+    vector<Fr> coeffs = evals;
+    ntt_inverse(coeffs, findPrimitiveRoot(n));
+
+    // Coset c is shift * w_kn^c * H_n, its entry i sits at index c + k*i
+    Fr omega_kn = findPrimitiveRoot(k * n);
+    vector<vector<Fr>> cosets(k, coeffs);
+    Fr offset = shift;
+    for (size_t c = 0; c < k; c++) {
+        scaleByPowers(cosets[c], offset);
+        offset *= omega_kn;
+    }
+    ntt_transform_batch(cosets, findPrimitiveRoot(n));
+
+    vector<Fr> result(k * n);
+    for (size_t c = 0; c < k; c++) {
+        for (size_t i = 0; i < n; i++) result[c + k * i] = cosets[c][i];
+    }
+    return result;
+}
+
+void divide_by_vanishing_coset(vector<Fr> &evals, size_t l, Fr shift) {
+    size_t N = evals.size();
+    size_t m = max((size_t)1, N / l);
+
+    // (shift * w_N^i)^l - 1 only depends on i mod m
+    Fr step, shift_l;
+    Fr::pow(step, findPrimitiveRoot(N), l);
+    Fr::pow(shift_l, shift, l);
+
+    vector<Fr> z_inv(m);
+    Fr power = shift_l;
+    for (size_t c = 0; c < m; c++) {
+        z_inv[c] = power - 1;
+        if (z_inv[c].isZero()) throw runtime_error("Coset intersects the vanishing subgroup.");
+        PROFILE_COUNT(FieldInversion, 1);
+        Fr::inv(z_inv[c], z_inv[c]);
+        power *= step;
+    }
+
+    parallelFor(N, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; i++) evals[i] *= z_inv[i % m];
+    }, 0, NTT_PARALLEL_THRESHOLD);
 }
 
 vector<Fr> polynomial_interpolation(vector<Fr> &A, Fr omega) {
@@ -73,24 +906,68 @@ vector<Fr> polynomial_interpolation(vector<Fr> &A, Fr omega) {
     return A;
 }
 
-vector<Fr> polynomial_multiply(vector<Fr> &A, vector<Fr> &B, Fr omega) {
+vector<Fr> polynomial_multiply(const vector<Fr> &A, const vector<Fr> &B, Fr omega) {
     size_t A_n = A.size();
     size_t B_n = B.size();
 
     size_t n = 1;
     while (n < A_n + B_n) n *= 2;
 
-    A.resize(n, 0);
-    B.resize(n, 0);
+    // Padded copies, the inputs stay in coefficient form
+    vector<Fr> a(n, 0), result(n, 0);
+    copy(A.begin(), A.end(), a.begin());
+    copy(B.begin(), B.end(), result.begin());
 
-    ntt_transform(A, omega);
-    ntt_transform(B, omega);
+    ntt_transform(a, omega);
+    ntt_transform(result, omega);
 
-    vector<Fr> result(n);
     for (size_t i = 0; i < n; i++) {
-        result[i] = A[i] * B[i];
+        result[i] *= a[i];
     }
 
     ntt_inverse(result, omega);
     return result;
 }
+
+// Group version of butterflies(), each stage is split across threads
+static void butterflies_g1(vector<G1> &A, const vector<uint32_t> &rev, const vector<Fr> &tw) {
+    size_t n = A.size();
+    PROFILE_COUNT(G1Mul, n / 2 * log2(n));
+
+    for (size_t i = 0; i < n; ++i) {
+        size_t j = rev[i];
+        if (i < j) swap(A[i], A[j]);
+    }
+
+    for (size_t half = 1; half < n; half <<= 1) {
+        const Fr *w = &tw[half - 1];
+
+        // The n/2 butterflies of a stage are independent
+        parallelFor(n / 2, [&](size_t begin, size_t end, size_t) {
+            for (size_t b = begin; b < end; b++) {
+                size_t i = (b / half) * 2 * half, j = b % half;
+                G1 u = A[i + j], v;
+                G1::mul(v, A[i + j + half], w[j]);
+                G1::add(A[i + j], u, v);
+                G1::sub(A[i + j + half], u, v);
+            }
+        }, 0, 256);
+    }
+}
+
+void ntt_transform_g1(vector<G1> &A, Fr omega) {
+    unique_ptr<EvaluationDomain> owned;
+    const EvaluationDomain &domain = domainFor(A.size(), omega, owned);
+    butterflies_g1(A, domain.bitReversal(), domain.twiddles());
+}
+
+void ntt_inverse_g1(vector<G1> &A, Fr omega) {
+    unique_ptr<EvaluationDomain> owned;
+    const EvaluationDomain &domain = domainFor(A.size(), omega, owned);
+    butterflies_g1(A, domain.bitReversal(), domain.twiddles(true));
+    PROFILE_COUNT(G1Mul, A.size());
+
+    parallelFor(A.size(), [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; i++) G1::mul(A[i], A[i], domain.n_inv);
+    }, 0, 256);
+}
@@ -5,6 +5,8 @@
 #include <vector>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
+#include <mutex>
 
 using namespace mcl;
 using namespace bn;
@@ -25,6 +27,131 @@ size_t bitReverse(size_t x, size_t logN);
  */
 Fr findPrimitiveRoot(size_t N);
 
+/**
+ * @brief Butterfly kernel used by the NTT
+ *
+ * Generic is the original operator-based loop. Unrolled goes straight to
+ * mcl's in-place Montgomery routines, which mcl JIT-compiles for the host
+ * CPU at initPairing(). It also skips unit twiddles and interleaves two
+ * butterflies per iteration. Both are portable.
+ *
+ * Avx2 and Avx512Ifma multiply 4 and 8 butterflies at once on the raw
+ * Montgomery limbs of Fr, in 29-bit and 52-bit limbs. They need the
+ * instruction set at run time and a 4-limb Montgomery Fr below 2^254, as
+ * for BN_SNARK1. Auto times every supported kernel once on first use and
+ * keeps the fastest.
+ */
+enum class NttKernel {
+    Auto,
+    Generic,
+    Unrolled,
+    Avx2,
+    Avx512Ifma
+};
+
+// Whether this CPU and Fr can run the kernel, Auto, Generic and Unrolled always can
+bool nttKernelSupported(NttKernel kernel);
+
+/**
+ * @brief Selects the butterfly kernel used by every field NTT
+ * @param kernel Kernel to use, Auto picks the fastest available
+ *
+ * Throws runtime_error if the kernel is not supported.
+ */
+void setNttKernel(NttKernel kernel);
+
+/**
+ * @brief Returns the name of the butterfly kernel currently in use
+ * @return "generic", "unrolled", "avx2" or "avx512-ifma"
+ */
+const char *nttKernelName();
+
+/**
+ * @brief Returns the primitive 2^logN-th root of unity from the cached 2-adic root table
+ * @param logN Log base 2 of the order (at least 1)
+ * @return The same root findPrimitiveRoot(2^logN) returns
+ *
+ * The table roots[k] = sqrt(roots[k-1]), roots[1] = -1, is built once on first use.
+ */
+Fr rootOfUnity(size_t logN);
+
+/**
+ * @brief Precomputed data for NTTs over the subgroup of size 2^logN
+ *
+ * Holds the bit-reversal permutation, the forward and inverse twiddles of
+ * every butterfly stage and n^-1, so repeated transforms of the same size
+ * only run the butterflies. Stage twiddles are stored back to back: the
+ * stage with half-length h reads omega_2h^j from twiddles()[h - 1 + j].
+ *
+ * The permutation and twiddles take about 2.5 n elements, so they are built
+ * on first radix-2 use rather than with the domain. Canonical domains large
+ * enough for the four-step NTT never build them unless a radix-2 path, such
+ * as the interleaved batch or the G1 NTT, asks for them.
+ */
+class EvaluationDomain {
+public:
+    size_t logN;
+    size_t size;
+    Fr omega;
+    Fr omega_inv;
+    Fr n_inv;
+
+    /**
+     * @brief Builds the tables for the domain generated by omega
+     * @param logN Log base 2 of the domain size
+     * @param omega Primitive 2^logN-th root of unity
+     */
+    EvaluationDomain(size_t logN, Fr omega);
+
+    /**
+     * @brief Returns the shared domain for rootOfUnity(logN), built on first use
+     * @param logN Log base 2 of the domain size
+     * @return Cached domain, valid for the lifetime of the program
+     */
+    static const EvaluationDomain &get(size_t logN);
+
+    // Bit-reversal permutation of the indices, built on first use
+    const vector<uint32_t> &bitReversal() const;
+
+    // Forward or inverse stage twiddles, built on first use
+    const vector<Fr> &twiddles(bool inverse = false) const;
+
+    /**
+     * @brief In-place forward NTT, same result as ntt_transform(A, omega)
+     * @param A Vector of exactly size field elements
+     */
+    void ntt(vector<Fr> &A) const;
+
+    /**
+     * @brief In-place inverse NTT, same result as ntt_inverse(A, omega)
+     * @param A Vector of exactly size field elements
+     */
+    void intt(vector<Fr> &A) const;
+
+    /**
+     * @brief In-place forward NTT using the four-step (Bailey) algorithm
+     * @param A Vector of exactly size field elements
+     *
+     * ntt() switches to this automatically for large canonical domains. It
+     * needs the canonical root and logN >= 2, and uses a scratch copy of A.
+     */
+    void nttFourStep(vector<Fr> &A) const;
+
+    /**
+     * @brief In-place inverse NTT using the four-step (Bailey) algorithm
+     * @param A Vector of exactly size field elements
+     */
+    void inttFourStep(vector<Fr> &A) const;
+
+private:
+    mutable once_flag tables_once;
+    mutable vector<uint32_t> rev_table;
+    mutable vector<Fr> twiddle_table;
+    mutable vector<Fr> twiddle_inv_table;
+
+    void buildTables() const;
+};
+
 /**
  * @brief Performs Number Theoretic Transform (NTT) on the input array
  * @param A Input/output vector of field elements (size must be power of 2)
@@ -33,6 +160,8 @@ Fr findPrimitiveRoot(size_t N);
  * The function performs in-place NTT transformation.
  * After calling this function, A[i] will contain the i-th coefficient
  * of the NTT of the original polynomial.
+ * When omega is the canonical root for A.size() the cached
+ * EvaluationDomain tables are used.
  */
 void ntt_transform(vector<Fr> &A, Fr omega);
 
@@ -46,6 +175,87 @@ void ntt_transform(vector<Fr> &A, Fr omega);
  */
 void ntt_inverse(vector<Fr> &A, Fr omega);
 
+/**
+ * @brief Performs the NTT on a batch of equal-length polynomials
+ * @param polys Polynomials transformed in place (all sizes equal, power of 2)
+ * @param omega Primitive N-th root of unity where N = polys[i].size()
+ *
+ * All transforms share one domain. Batches of at least getThreadCount()
+ * polynomials are split across threads by polynomial.
+ */
+void ntt_transform_batch(vector<vector<Fr>> &polys, Fr omega);
+
+/**
+ * @brief Performs the inverse NTT on a batch of equal-length polynomials
+ * @param polys Polynomials transformed in place (all sizes equal, power of 2)
+ * @param omega Primitive N-th root of unity where N = polys[i].size()
+ */
+void ntt_inverse_batch(vector<vector<Fr>> &polys, Fr omega);
+
+/**
+ * @brief Performs the NTT on count polynomials stored interleaved (column-major)
+ * @param A Input/output vector, A[i * count + p] is entry i of polynomial p
+ * @param count Number of polynomials, A.size() / count must be a power of 2
+ * @param omega Primitive N-th root of unity where N = A.size() / count
+ *
+ * Each butterfly applies one twiddle to count adjacent elements, so twiddle
+ * loads are shared across the batch and memory is streamed contiguously.
+ */
+void ntt_transform_interleaved(vector<Fr> &A, size_t count, Fr omega);
+
+/**
+ * @brief Performs the inverse NTT on count interleaved polynomials
+ * @param A Input/output vector, A[i * count + p] is entry i of polynomial p
+ * @param count Number of polynomials, A.size() / count must be a power of 2
+ * @param omega Primitive N-th root of unity where N = A.size() / count
+ */
+void ntt_inverse_interleaved(vector<Fr> &A, size_t count, Fr omega);
+
+/**
+ * @brief Returns the default coset shift, the multiplicative generator 5 of Fr
+ * @return A shift that lies outside every power-of-two subgroup
+ */
+Fr cosetShift();
+
+/**
+ * @brief Performs the NTT over the coset shift * <omega>
+ * @param A Input coefficients, output evaluations at shift * omega^i (size must be power of 2)
+ * @param omega Primitive N-th root of unity where N = A.size()
+ * @param shift Coset representative
+ */
+void coset_ntt(vector<Fr> &A, Fr omega, Fr shift);
+
+/**
+ * @brief Performs the inverse NTT over the coset shift * <omega>
+ * @param A Input evaluations at shift * omega^i, output coefficients
+ * @param omega Primitive N-th root of unity where N = A.size()
+ * @param shift Coset representative
+ */
+void coset_intt(vector<Fr> &A, Fr omega, Fr shift);
+
+/**
+ * @brief Extends evaluations on the subgroup of size n to the coset shift * H_(k*n)
+ * @param evals Evaluations at w_n^i, w_n = findPrimitiveRoot(n), n a power of 2
+ * @param k Blowup factor (power of 2)
+ * @param shift Coset representative
+ * @return k*n evaluations, entry i at shift * w_(kn)^i
+ *
+ * Interpolates once, then runs k size-n NTTs over the cosets
+ * shift * w_(kn)^c * H_n as one batch instead of one size-kn transform.
+ */
+vector<Fr> low_degree_extension(const vector<Fr> &evals, size_t k, Fr shift);
+
+/**
+ * @brief Divides evaluations on a coset by the vanishing polynomial x^l - 1
+ * @param evals Evaluations at shift * w_N^i, w_N = findPrimitiveRoot(N), N = evals.size()
+ * @param l Size of the subgroup H (power of 2)
+ * @param shift Coset representative, must lie outside H
+ *
+ * x^l - 1 takes only max(1, N/l) distinct values on the coset, so the division
+ * costs that many inversions plus one multiplication per point.
+ */
+void divide_by_vanishing_coset(vector<Fr> &evals, size_t l, Fr shift);
+
 /**
  * @brief Performs polynomial interpolation using inverse NTT
  * @param A Vector of polynomial evaluations at roots of unity
@@ -65,9 +275,26 @@ vector<Fr> polynomial_interpolation(vector<Fr> &A, Fr omega);
  * @param B Second polynomial coefficients
  * @return Product polynomial coefficients
  * 
- * The result size will be a.size() + b.size() - 1.
- * Input vectors will be zero-padded to the next power of 2 if needed.
+ * The result is zero-padded to the next power of 2 above a.size() + b.size() - 1,
+ * the inputs are left unchanged.
+ */
+vector<Fr> polynomial_multiply(const vector<Fr> &A, const vector<Fr> &B, Fr omega);
+
+/**
+ * @brief Performs the NTT over G1, A[k] <- sum_j omega^(jk) * A[j]
+ * @param A Input/output vector of G1 points (size must be power of 2)
+ * @param omega Primitive N-th root of unity where N = A.size()
+ *
+ * Same butterfly network as ntt_transform() with G1 additions and scalar
+ * multiplications. Each stage is split across threads.
+ */
+void ntt_transform_g1(vector<G1> &A, Fr omega);
+
+/**
+ * @brief Performs the inverse NTT over G1
+ * @param A Input/output vector of G1 points (size must be power of 2)
+ * @param omega Primitive N-th root of unity where N = A.size()
  */
-vector<Fr> polynomial_multiply(vector<Fr> &A, vector<Fr> &B, Fr omega);
+void ntt_inverse_g1(vector<G1> &A, Fr omega);
 
 #endif // NTT_H
@@ -0,0 +1,136 @@
+#include "parallel.h"
+#include <thread>
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <algorithm>
+
+using namespace std;
+
+static atomic<size_t> thread_count(0);
+
+// Set while a thread runs a parallelFor chunk, nested calls then run inline
+static thread_local bool in_parallel = false;
+
+// Persistent workers shared by every parallelFor call. The pool only grows,
+// so a larger thread count set later just adds workers.
+class ThreadPool {
+public:
+    ~ThreadPool() {
+        {
+            lock_guard<mutex> guard(lock);
+            stop = true;
+        }
+        wake.notify_all();
+        for (auto &t : workers) t.join();
+    }
+
+    void reserve(size_t n) {
+        lock_guard<mutex> guard(lock);
+        while (workers.size() < n) workers.emplace_back(&ThreadPool::run, this);
+    }
+
+    void submit(const function<void()> &task) {
+        {
+            lock_guard<mutex> guard(lock);
+            tasks.push_back(task);
+        }
+        wake.notify_one();
+    }
+
+private:
+    mutex lock;
+    condition_variable wake;
+    deque<function<void()>> tasks;
+    vector<thread> workers;
+    bool stop = false;
+
+    void run() {
+        while (true) {
+            function<void()> task;
+            {
+                unique_lock<mutex> guard(lock);
+                wake.wait(guard, [this] { return stop || !tasks.empty(); });
+                if (stop && tasks.empty()) return;
+                task = tasks.front();
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+};
+
+static ThreadPool &pool() {
+    static ThreadPool instance;
+    return instance;
+}
+
+size_t getThreadCount() {
+    size_t n = thread_count.load();
+    if (n != 0) return n;
+
+    n = thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+void setThreadCount(size_t threads) {
+    thread_count.store(threads);
+}
+
+// Counts outstanding chunks of one parallelFor call
+struct ChunkLatch {
+    mutex lock;
+    condition_variable done;
+    size_t remaining;
+    exception_ptr error;
+};
+
+static void runChunk(const function<void(size_t, size_t, size_t)> &fn, size_t begin, size_t end, size_t chunk, ChunkLatch &latch) {
+    in_parallel = true;
+    try {
+        fn(begin, end, chunk);
+    } catch (...) {
+        lock_guard<mutex> guard(latch.lock);
+        if (!latch.error) latch.error = current_exception();
+    }
+    in_parallel = false;
+}
+
+void parallelFor(size_t n, const function<void(size_t, size_t, size_t)> &fn, size_t threads, size_t grain) {
+    if (n == 0) return;
+    if (threads == 0) threads = getThreadCount();
+    if (grain == 0) grain = 1;
+
+    size_t chunks = min(threads, (n + grain - 1) / grain);
+    if (chunks <= 1 || in_parallel) {
+        fn(0, n, 0);
+        return;
+    }
+
+    pool().reserve(chunks - 1);
+
+    ChunkLatch latch;
+    latch.remaining = chunks - 1;
+
+    // Spread the remainder over the first chunks so sizes differ by at most one
+    size_t base = n / chunks, extra = n % chunks;
+    size_t begin = base + (extra > 0 ? 1 : 0);
+    for (size_t c = 1; c < chunks; c++) {
+        size_t end = begin + base + (c < extra ? 1 : 0);
+        pool().submit([&fn, &latch, begin, end, c] {
+            runChunk(fn, begin, end, c, latch);
+            lock_guard<mutex> guard(latch.lock);
+            if (--latch.remaining == 0) latch.done.notify_one();
+        });
+        begin = end;
+    }
+
+    runChunk(fn, 0, base + (extra > 0 ? 1 : 0), 0, latch);
+
+    unique_lock<mutex> guard(latch.lock);
+    latch.done.wait(guard, [&latch] { return latch.remaining == 0; });
+    if (latch.error) rethrow_exception(latch.error);
+}
@@ -0,0 +1,35 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <cstddef>
+#include <functional>
+
+using namespace std;
+
+/**
+ * @brief Returns the number of worker threads used by parallel routines
+ * @return Configured thread count (defaults to the hardware concurrency)
+ */
+size_t getThreadCount();
+
+/**
+ * @brief Sets the number of worker threads used by parallel routines
+ * @param threads Thread count, 0 restores the hardware concurrency
+ */
+void setThreadCount(size_t threads);
+
+/**
+ * @brief Splits the range [0, n) into contiguous chunks and runs them in parallel
+ * @param n Size of the range
+ * @param fn Callback invoked as fn(begin, end, chunkIndex) for each chunk
+ * @param threads Maximum number of chunks, 0 uses getThreadCount()
+ * @param grain Minimum number of elements per chunk
+ *
+ * The remaining chunks run on a persistent worker pool while the calling
+ * thread runs the first chunk itself. Calls made from inside a chunk run
+ * inline on the calling thread, and the first exception thrown by a chunk
+ * is rethrown once all chunks have finished.
+ */
+void parallelFor(size_t n, const function<void(size_t, size_t, size_t)> &fn, size_t threads = 0, size_t grain = 1);
+
+#endif // PARALLEL_H
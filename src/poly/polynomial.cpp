@@ -0,0 +1,315 @@
+#include "polynomial.h"
+#include "../kzg/kzg.h"
+#include "../ntt/ntt.h"
+#include "../profile/profile.h"
+#include <mcl/bn.hpp>
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
+using namespace std;
+using namespace mcl;
+using namespace bn;
+
+// Below this many coefficients in the smaller factor, schoolbook multiplication beats the NTTs
+static const size_t SCHOOLBOOK_THRESHOLD = 32;
+
+static atomic<size_t> cache_limit(1 << 22);
+
+size_t Polynomial::getCacheLimit() {
+    return cache_limit.load();
+}
+
+void Polynomial::setCacheLimit(size_t elements) {
+    cache_limit.store(elements);
+}
+
+static bool isPowerOfTwo(size_t n) {
+    return n != 0 && (n & (n - 1)) == 0;
+}
+
+static size_t nextPowerOfTwo(size_t n) {
+    size_t p = 1;
+    while (p < n) p *= 2;
+    return p;
+}
+
+Polynomial Polynomial::fromCoefficients(vector<Fr> coeffs) {
+    Polynomial q;
+    q.length = coeffs.size();
+    q.coeffs = move(coeffs);
+    return q;
+}
+
+Polynomial Polynomial::fromEvaluations(vector<Fr> evals, size_t length) {
+    if (!isPowerOfTwo(evals.size())) throw runtime_error("Evaluation domain size must be a power of 2.");
+    if (length > evals.size()) throw runtime_error("Length exceeds the evaluation domain size.");
+
+    Polynomial q;
+    q.length = length == 0 ? evals.size() : length;
+    q.has_coeffs = false;
+    q.evals_size = evals.size();
+    q.evals_newer = true;
+    q.evals = move(evals);
+    return q;
+}
+
+void Polynomial::trimCache() {
+    if (!has_coeffs || evals_size == 0 || coeffs.size() + evals.size() <= getCacheLimit()) return;
+
+    if (evals_newer) {
+        vector<Fr>().swap(coeffs);
+        has_coeffs = false;
+    } else {
+        vector<Fr>().swap(evals);
+        evals_size = 0;
+    }
+}
+
+const vector<Fr> &Polynomial::coefficients() const {
+    if (has_coeffs) return coeffs;
+
+    coeffs = evals;
+    ntt_inverse(coeffs, findPrimitiveRoot(evals_size));
+    coeffs.resize(length);
+    has_coeffs = true;
+    evals_newer = false;
+    return coeffs;
+}
+
+const vector<Fr> &Polynomial::evaluations(size_t n) const {
+    if (!isPowerOfTwo(n)) throw runtime_error("Evaluation domain size must be a power of 2.");
+    if (n < length) throw runtime_error("Evaluation domain is smaller than the polynomial.");
+    if (evals_size == n) return evals;
+
+    const vector<Fr> &c = coefficients();
+    vector<Fr> values(n, 0);
+    copy(c.begin(), c.end(), values.begin());
+    ntt_transform(values, findPrimitiveRoot(n));
+
+    evals.swap(values);
+    evals_size = n;
+    evals_newer = true;
+    return evals;
+}
+
+Fr Polynomial::evaluate(const Fr &x) const {
+    if (has_coeffs) return evaluatePoly(coeffs, x);
+
+    // Barycentric formula q(x) = (x^n - 1)/n * sum_j evals[j] w^j / (x - w^j)
+    size_t n = evals_size;
+    Fr omega = findPrimitiveRoot(n), power = 1;
+    vector<Fr> domain(n), diff(n);
+    for (size_t j = 0; j < n; j++) {
+        if (power == x) return evals[j];
+        domain[j] = power;
+        diff[j] = x - power;
+        power *= omega;
+    }
+
+    // One inversion for all the denominators
+    vector<Fr> prefix(n);
+    Fr acc = 1;
+    for (size_t j = 0; j < n; j++) {
+        prefix[j] = acc;
+        acc *= diff[j];
+    }
+    PROFILE_COUNT(FieldInversion, 1);
+    Fr::inv(acc, acc);
+
+    Fr sum = 0;
+    for (size_t j = n; j-- > 0;) {
+        Fr inv = acc * prefix[j];
+        acc *= diff[j];
+        sum += evals[j] * domain[j] * inv;
+    }
+
+    Fr xn;
+    Fr::pow(xn, x, n);
+    PROFILE_COUNT(FieldInversion, 1);
+    return (xn - 1) * sum / n;
+}
+
+// a + sign * b. Works on evaluations when one side has only those and the other
+// fits in that domain, so neither operand has to be interpolated.
+static Polynomial addScaled(const Polynomial &a, const Polynomial &b, const Fr &sign) {
+    size_t length = max(a.size(), b.size());
+
+    size_t n = 0;
+    if (!a.hasCoefficients() || !b.hasCoefficients()) {
+        if (a.evaluationDomainSize() >= length) n = a.evaluationDomainSize();
+        else if (b.evaluationDomainSize() >= length) n = b.evaluationDomainSize();
+    }
+
+    if (n != 0) {
+        vector<Fr> values = a.evaluations(n);
+        const vector<Fr> &other = b.evaluations(n);
+        for (size_t j = 0; j < n; j++) values[j] += sign * other[j];
+
+        return Polynomial::fromEvaluations(move(values), length);
+    }
+
+    vector<Fr> coeffs(length, 0);
+    const vector<Fr> &ca = a.coefficients(), &cb = b.coefficients();
+    for (size_t j = 0; j < ca.size(); j++) coeffs[j] = ca[j];
+    for (size_t j = 0; j < cb.size(); j++) coeffs[j] += sign * cb[j];
+    return Polynomial::fromCoefficients(move(coeffs));
+}
+
+Polynomial Polynomial::operator+(const Polynomial &other) const {
+    return addScaled(*this, other, 1);
+}
+
+Polynomial Polynomial::operator-(const Polynomial &other) const {
+    return addScaled(*this, other, -1);
+}
+
+// Schoolbook for a small factor, otherwise pointwise on a domain that holds the
+// product. An operand already evaluated on that domain is not transformed again.
+Polynomial Polynomial::operator*(const Polynomial &other) const {
+    if (length == 0 || other.length == 0) return Polynomial();
+
+    size_t product = length + other.length - 1;
+    if (min(length, other.length) <= SCHOOLBOOK_THRESHOLD && has_coeffs && other.has_coeffs) {
+        vector<Fr> result(product, 0);
+        for (size_t i = 0; i < length; i++) {
+            for (size_t j = 0; j < other.length; j++) result[i + j] += coeffs[i] * other.coeffs[j];
+        }
+        return fromCoefficients(move(result));
+    }
+
+    size_t n = nextPowerOfTwo(product);
+    vector<Fr> values = evaluations(n);
+    const vector<Fr> &rhs = other.evaluations(n);
+    for (size_t j = 0; j < n; j++) values[j] *= rhs[j];
+
+    return fromEvaluations(move(values), product);
+}
+
+// Scales every cached form, no conversion needed
+Polynomial Polynomial::scale(const Fr &c) const {
+    Polynomial result = *this;
+    for (auto &x : result.coeffs) x *= c;
+    for (auto &x : result.evals) x *= c;
+    return result;
+}
+
+// x^l - 1 is sparse, so the division is O(n) on coefficients. On the evaluation
+// domain itself Z_H can be zero, so evaluation-only operands are interpolated.
+Polynomial Polynomial::divideByVanishing(size_t l, Polynomial *remainder) const {
+    if (l == 0) throw runtime_error("Vanishing polynomial degree must be positive.");
+    const vector<Fr> &q = coefficients();
+
+    // q[j] = f[j - l] - f[j] + r[j], so f[k] = q[k + l] + f[k + l] from the top down
+    size_t size = length > l ? length - l : 0;
+    vector<Fr> f(size);
+    for (size_t k = size; k-- > 0;) {
+        f[k] = q[k + l];
+        if (k + l < size) f[k] += f[k + l];
+    }
+
+    if (remainder) {
+        vector<Fr> r(min(length, l));
+        for (size_t j = 0; j < r.size(); j++) r[j] = q[j] + (j < size ? f[j] : Fr(0));
+        *remainder = fromCoefficients(move(r));
+    }
+
+    return fromCoefficients(move(f));
+}
+
+vector<Fr> multiplyPolys(PolyView a, PolyView b) {
+    if (a.empty() || b.empty()) return vector<Fr>();
+
+    size_t product = a.size + b.size - 1;
+    if (min(a.size, b.size) <= SCHOOLBOOK_THRESHOLD) {
+        vector<Fr> result(product, 0);
+        for (size_t i = 0; i < a.size; i++) {
+            for (size_t j = 0; j < b.size; j++) result[i + j] += a[i] * b[j];
+        }
+        return result;
+    }
+
+    // polynomial_multiply() works on the power of 2 at or above a.size + b.size
+    vector<Fr> result = polynomial_multiply(vector<Fr>(a.data, a.data + a.size), vector<Fr>(b.data, b.data + b.size),
+        findPrimitiveRoot(nextPowerOfTwo(a.size + b.size)));
+    result.resize(product);
+    return result;
+}
+
+// Extends g = f^-1 mod x^g.size() until it holds at least k terms
+static void extendInverse(PolyView f, vector<Fr> &g, size_t k) {
+    if (g.empty()) {
+        if (f.empty() || f[0].isZero()) throw runtime_error("Power series is not invertible.");
+        g.assign(1, Fr(0));
+        PROFILE_COUNT(FieldInversion, 1);
+        Fr::inv(g[0], f[0]);
+    }
+
+    while (g.size() < k) {
+        size_t t = 2 * g.size();
+
+        // e = f g mod x^t is 1 + O(x^(t/2)), the correction is g (1 - e)
+        vector<Fr> e = multiplyPolys(PolyView(f.data, min(f.size, t)), g);
+        e.resize(t, 0);
+        for (auto &x : e) x = -x;
+        e[0] += 2;
+
+        g = multiplyPolys(g, e);
+        g.resize(t);
+    }
+}
+
+vector<Fr> powerSeriesInverse(PolyView f, size_t k) {
+    vector<Fr> g;
+    if (k == 0) return g;
+    extendInverse(f, g, k);
+    g.resize(k);
+    return g;
+}
+
+PolynomialDivisor::PolynomialDivisor(PolyView b) {
+    size_t size = b.size;
+    while (size > 0 && b[size - 1].isZero()) size--;
+    if (size == 0) throw runtime_error("Division by the zero polynomial.");
+
+    divisor.assign(b.data, b.data + size);
+}
+
+void PolynomialDivisor::divide(PolyView a, vector<Fr> &quotient, vector<Fr> &remainder) {
+    size_t m = degree();
+    if (a.size <= m) {
+        quotient.clear();
+        remainder.assign(m, Fr(0));
+        copy(a.data, a.data + a.size, remainder.begin());
+        return;
+    }
+
+    // rev(q) = rev(a) * rev(b)^-1 mod x^k
+    size_t k = a.size - m;
+    if (rev_inverse.size() < k) {
+        vector<Fr> rev_b(divisor.rbegin(), divisor.rend());
+        extendInverse(rev_b, rev_inverse, k);
+    }
+
+    vector<Fr> rev_a(k);
+    for (size_t j = 0; j < k; j++) rev_a[j] = a[a.size - 1 - j];
+    quotient = multiplyPolys(rev_a, PolyView(rev_inverse.data(), k));
+    quotient.resize(k);
+    reverse(quotient.begin(), quotient.end());
+
+    // r = a - q b, only the low m coefficients survive
+    vector<Fr> qb = multiplyPolys(PolyView(quotient.data(), min(k, m)), divisor);
+    remainder.assign(a.data, a.data + m);
+    for (size_t j = 0; j < m; j++) remainder[j] -= qb[j];
+}
+
+void divideWithRemainder(PolyView a, PolyView b, vector<Fr> &quotient, vector<Fr> &remainder) {
+    PolynomialDivisor(b).divide(a, quotient, remainder);
+}
+
+KZG::Commitment commit(const KZG::PublicKey &pk, const Polynomial &q) {
+    size_t n = q.evaluationDomainSize();
+    if (!q.hasCoefficients() && pk.lagrange.count(n)) return commitLagrange(pk, q.evaluations(n));
+
+    return commit(pk, PolyView(q.coefficients()));
+}
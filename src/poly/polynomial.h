@@ -0,0 +1,127 @@
+#ifndef POLYNOMIAL_H
+#define POLYNOMIAL_H
+
+#include <mcl/bn.hpp>
+#include <vector>
+#include "../kzg/kzg.h"
+
+using namespace mcl;
+using namespace bn;
+using namespace std;
+
+/**
+ * @brief Univariate polynomial held in coefficient form, evaluation form or both
+ *
+ * The evaluation form holds the values on the domain of size n (a power of 2)
+ * generated by findPrimitiveRoot(n), the same domain commitLagrange() uses.
+ * A form is computed from the other only when an operation needs it and is
+ * then cached next to its source. The const accessors never free a form, so
+ * trimCache() is the one place a polynomial gives memory back.
+ *
+ * The length is the number of coefficients, i.e. one more than the degree
+ * bound. A polynomial built from n evaluations has length n.
+ *
+ * The lazy conversions update cached state from const methods, so a
+ * Polynomial must not be shared between threads without synchronization.
+ */
+class Polynomial {
+public:
+    Polynomial() : length(0), has_coeffs(true), evals_size(0), evals_newer(false) {}
+
+    static Polynomial fromCoefficients(vector<Fr> coeffs);
+
+    // evals[j] = q(w^j), w = findPrimitiveRoot(evals.size()). A known length
+    // below evals.size() trims the coefficients, 0 means evals.size().
+    static Polynomial fromEvaluations(vector<Fr> evals, size_t length = 0);
+
+    size_t size() const { return length; }
+    bool hasCoefficients() const { return has_coeffs; }
+    bool hasEvaluations(size_t n) const { return evals_size == n; }
+    size_t evaluationDomainSize() const { return evals_size; } // 0 if there is no evaluation form
+
+    // Converts if needed. The result stays valid until the polynomial is
+    // assigned to or trimCache() is called.
+    const vector<Fr> &coefficients() const;
+
+    // Values on the size-n domain, throws if n is not a power of 2 or n < size().
+    // Evaluating on another domain replaces them, otherwise valid as coefficients().
+    const vector<Fr> &evaluations(size_t n) const;
+
+    // q(x), from whichever form is present without converting
+    Fr evaluate(const Fr &x) const;
+
+    Polynomial operator+(const Polynomial &other) const;
+    Polynomial operator-(const Polynomial &other) const;
+    Polynomial operator*(const Polynomial &other) const;
+    Polynomial scale(const Fr &c) const;
+
+    // Quotient by Z_H = x^l - 1, the remainder is written to remainder if given
+    Polynomial divideByVanishing(size_t l, Polynomial *remainder = nullptr) const;
+
+    // Coefficient view for the KZG and PIOP functions
+    operator PolyView() const { return PolyView(coefficients()); }
+
+    // Frees the form the newer one was converted from when both together hold
+    // more than getCacheLimit() elements
+    void trimCache();
+
+    static size_t getCacheLimit();
+    static void setCacheLimit(size_t elements);
+
+private:
+    size_t length;
+    mutable bool has_coeffs;
+    mutable vector<Fr> coeffs;
+    mutable size_t evals_size; // 0 when no evaluation form is cached
+    mutable vector<Fr> evals;
+    mutable bool evals_newer; // Which form trimCache() keeps when both are cached
+};
+
+/**
+ * @brief Product of two coefficient vectors
+ *
+ * Schoolbook for a small factor, otherwise polynomial_multiply() on the
+ * smallest power-of-2 domain. The result has a.size() + b.size() - 1 entries.
+ */
+vector<Fr> multiplyPolys(PolyView a, PolyView b);
+
+/**
+ * @brief Inverse of f as a power series, f * g = 1 mod x^k
+ *
+ * Newton iteration g <- g (2 - f g) doubles the precision each step, so the
+ * cost is a constant number of size-k multiplications. Throws if f[0] = 0.
+ */
+vector<Fr> powerSeriesInverse(PolyView f, size_t k);
+
+/**
+ * @brief Divides by a fixed polynomial b in O(n log n)
+ *
+ * The quotient of a by b is rev(rev(a) * rev(b)^-1 mod x^(n-m+1)) for
+ * n = a.size() and m = b.size() - 1. The inverse of rev(b) is kept and only
+ * extended when a longer dividend needs more precision, so dividing many
+ * polynomials by the same divisor pays for the Newton iteration once.
+ */
+class PolynomialDivisor {
+public:
+    // Throws if b is zero, leading zero coefficients are ignored
+    explicit PolynomialDivisor(PolyView b);
+
+    size_t degree() const { return divisor.size() - 1; }
+    const vector<Fr> &polynomial() const { return divisor; }
+
+    // a = quotient * b + remainder with remainder.size() = degree()
+    void divide(PolyView a, vector<Fr> &quotient, vector<Fr> &remainder);
+
+private:
+    vector<Fr> divisor;
+    vector<Fr> rev_inverse; // rev(b)^-1 mod x^rev_inverse.size()
+};
+
+// One-off division with remainder, see PolynomialDivisor
+void divideWithRemainder(PolyView a, PolyView b, vector<Fr> &quotient, vector<Fr> &remainder);
+
+// Commits from the evaluation form with the Lagrange SRS when it is set up for
+// that domain and no coefficients are cached, otherwise from the coefficients.
+KZG::Commitment commit(const KZG::PublicKey &pk, const Polynomial &q);
+
+#endif // POLYNOMIAL_H
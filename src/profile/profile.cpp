@@ -0,0 +1,272 @@
+#include "profile.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+using namespace std::chrono;
+
+static const size_t NO_PARENT = (size_t)-1;
+
+// Transform sizes are powers of two, counted by log2
+static const size_t MAX_NTT_LOG = 64;
+
+struct SpanEvent {
+    const char *name;
+    uint64_t start_ns;
+    uint64_t end_ns; // 0 while the span is open
+    size_t parent;
+};
+
+// Spans of one thread. Only the owning thread appends, but summaries and resets
+// may run on other threads meanwhile, so both sides take the log's lock. It is
+// uncontended while nothing reads the profile.
+struct ThreadLog {
+    mutex lock;
+    uint32_t tid;
+    uint64_t generation;
+    vector<SpanEvent> events;
+    vector<size_t> open; // Indices of the open spans, innermost last
+};
+
+static mutex logs_lock;
+
+// Logs outlive their threads so spans recorded on finished threads still export
+static vector<unique_ptr<ThreadLog>> &threadLogs() {
+    static vector<unique_ptr<ThreadLog>> logs;
+    return logs;
+}
+
+static atomic<uint64_t> counters[(size_t)ProfileCounter::Count];
+static atomic<uint64_t> ntt_counts[MAX_NTT_LOG];
+
+static int64_t clockNs() {
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Start of the trace on the steady clock, read by recording threads while a
+// reset moves it
+static atomic<int64_t> &epochNs() {
+    static atomic<int64_t> start(clockNs());
+    return start;
+}
+
+const char *profileCounterName(ProfileCounter counter) {
+    switch (counter) {
+        case ProfileCounter::G1Mul: return "g1_mul";
+        case ProfileCounter::G2Mul: return "g2_mul";
+        case ProfileCounter::MSMPoints: return "msm_points";
+        case ProfileCounter::MillerLoop: return "miller_loop";
+        case ProfileCounter::FinalExp: return "final_exp";
+        case ProfileCounter::FieldInversion: return "field_inv";
+        case ProfileCounter::NTT: return "ntt";
+        default: return "unknown";
+    }
+}
+
+bool profileEnabled() {
+#ifdef KZG_PROFILE
+    return true;
+#else
+    return false;
+#endif
+}
+
+void profileReset() {
+    lock_guard<mutex> guard(logs_lock);
+
+    // Moved before the logs are cleared, so every span kept after the reset
+    // starts on the new epoch
+    epochNs().store(clockNs());
+    for (auto &log : threadLogs()) {
+        lock_guard<mutex> log_guard(log->lock);
+        log->events.clear();
+        log->open.clear();
+        log->generation++;
+    }
+    for (auto &c : counters) c.store(0);
+    for (auto &c : ntt_counts) c.store(0);
+}
+
+#ifdef KZG_PROFILE
+
+static uint64_t nowNs() {
+    // Offset by one so a span can never end at 0, which marks it as open
+    return clockNs() - epochNs().load() + 1;
+}
+
+static ThreadLog &localLog() {
+    static thread_local ThreadLog *log = nullptr;
+    if (!log) {
+        lock_guard<mutex> guard(logs_lock);
+        threadLogs().emplace_back(new ThreadLog());
+        log = threadLogs().back().get();
+        log->tid = threadLogs().size();
+        log->generation = 0;
+    }
+    return *log;
+}
+
+ProfileSpan::ProfileSpan(const char *name) {
+    ThreadLog &log = localLog();
+    lock_guard<mutex> guard(log.lock);
+    index = log.events.size();
+    generation = log.generation;
+
+    SpanEvent event;
+    event.name = name;
+    event.parent = log.open.empty() ? NO_PARENT : log.open.back();
+    event.end_ns = 0;
+    event.start_ns = nowNs();
+    log.events.push_back(event);
+    log.open.push_back(index);
+}
+
+ProfileSpan::~ProfileSpan() {
+    uint64_t end = nowNs();
+    ThreadLog &log = localLog();
+    lock_guard<mutex> guard(log.lock);
+    if (log.generation != generation) return; // Reset while open
+
+    log.events[index].end_ns = end;
+    log.open.pop_back();
+}
+
+void profileCount(ProfileCounter counter, uint64_t n) {
+    counters[(size_t)counter].fetch_add(n, memory_order_relaxed);
+}
+
+void profileNTT(size_t size, uint64_t count) {
+    size_t log = 0;
+    while (((size_t)1 << log) < size && log + 1 < MAX_NTT_LOG) log++;
+    ntt_counts[log].fetch_add(count, memory_order_relaxed);
+    counters[(size_t)ProfileCounter::NTT].fetch_add(count, memory_order_relaxed);
+}
+
+#endif
+
+// '/' sorts below every other character, so children follow their parent directly
+static string sortKey(const string &path) {
+    string key = path;
+    replace(key.begin(), key.end(), '/', '\x01');
+    return key;
+}
+
+ProfileSummary profileSummary() {
+    ProfileSummary summary;
+    for (size_t c = 0; c < (size_t)ProfileCounter::Count; c++) summary.counters[c] = counters[c].load();
+    for (size_t log = 0; log < MAX_NTT_LOG; log++) {
+        uint64_t n = ntt_counts[log].load();
+        if (n != 0) summary.ntt_sizes[(size_t)1 << log] = n;
+    }
+
+    map<string, ProfileSpanStats> by_path;
+    lock_guard<mutex> guard(logs_lock);
+    for (const auto &log : threadLogs()) {
+        vector<SpanEvent> events;
+        {
+            lock_guard<mutex> log_guard(log->lock);
+            events = log->events;
+        }
+
+        // Parents are recorded before their children
+        vector<string> paths(events.size());
+        vector<size_t> depths(events.size(), 0);
+        vector<uint64_t> child_ns(events.size(), 0);
+        for (size_t k = 0; k < events.size(); k++) {
+            size_t parent = events[k].parent;
+            paths[k] = parent == NO_PARENT ? events[k].name : paths[parent] + "/" + events[k].name;
+            depths[k] = parent == NO_PARENT ? 0 : depths[parent] + 1;
+            if (parent != NO_PARENT && events[k].end_ns != 0) child_ns[parent] += events[k].end_ns - events[k].start_ns;
+        }
+
+        for (size_t k = 0; k < events.size(); k++) {
+            if (events[k].end_ns == 0) continue;
+
+            uint64_t duration = events[k].end_ns - events[k].start_ns;
+            auto it = by_path.find(sortKey(paths[k]));
+            if (it == by_path.end()) {
+                ProfileSpanStats stats = {paths[k], depths[k], 0, 0, 0};
+                it = by_path.insert(make_pair(sortKey(paths[k]), stats)).first;
+            }
+            it->second.calls++;
+            it->second.total_ns += duration;
+            it->second.self_ns += duration - min(duration, child_ns[k]);
+        }
+    }
+
+    for (const auto &entry : by_path) summary.spans.push_back(entry.second);
+    return summary;
+}
+
+void printProfileSummary(ostream &out, const ProfileSummary &summary) {
+    out << left << setw(48) << "Span" << right << setw(10) << "Calls" << setw(16) << "Total (us)" << setw(16) << "Self (us)" << endl;
+    for (const auto &span : summary.spans) {
+        size_t slash = span.path.rfind('/');
+        string name = string(2 * span.depth, ' ') + (slash == string::npos ? span.path : span.path.substr(slash + 1));
+        out << left << setw(48) << name << right << setw(10) << span.calls << fixed << setprecision(3)
+            << setw(16) << span.total_ns / 1e3 << setw(16) << span.self_ns / 1e3 << endl;
+    }
+
+    out << endl;
+    for (size_t c = 0; c < (size_t)ProfileCounter::Count; c++) {
+        out << left << setw(16) << profileCounterName((ProfileCounter)c) << right << setw(14) << summary.counters[c] << endl;
+    }
+    for (const auto &entry : summary.ntt_sizes) {
+        out << left << setw(16) << ("ntt_" + to_string(entry.first)) << right << setw(14) << entry.second << endl;
+    }
+}
+
+static string jsonString(const char *s) {
+    string out = "\"";
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') out += '\\';
+        out += *s;
+    }
+    return out + "\"";
+}
+
+string chromeTrace() {
+    ProfileSummary summary = profileSummary();
+
+    ostringstream out;
+    out << fixed << setprecision(3);
+    out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+
+    bool first = true;
+    {
+        lock_guard<mutex> guard(logs_lock);
+        for (const auto &log : threadLogs()) {
+            lock_guard<mutex> log_guard(log->lock);
+            for (const auto &event : log->events) {
+                if (event.end_ns == 0) continue;
+
+                // Timestamps are in microseconds
+                out << (first ? "\n" : ",\n") << "  {\"name\": " << jsonString(event.name) << ", \"ph\": \"X\", \"pid\": 1, \"tid\": "
+                    << log->tid << ", \"ts\": " << event.start_ns / 1e3 << ", \"dur\": " << (event.end_ns - event.start_ns) / 1e3 << "}";
+                first = false;
+            }
+        }
+    }
+
+    out << "\n], \"otherData\": {";
+    for (size_t c = 0; c < (size_t)ProfileCounter::Count; c++) {
+        out << (c ? ", " : "") << "\"" << profileCounterName((ProfileCounter)c) << "\": " << summary.counters[c];
+    }
+    for (const auto &entry : summary.ntt_sizes) out << ", \"ntt_" << entry.first << "\": " << entry.second;
+    out << "}}\n";
+
+    return out.str();
+}
+
+void writeChromeTrace(const string &path) {
+    ofstream out(path);
+    if (!out) throw runtime_error("Cannot write " + path);
+    out << chromeTrace();
+}
@@ -0,0 +1,124 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Hot-path operations counted by the profiler
+ *
+ * MillerLoop counts pairs fed to a Miller loop, so a pairing check on two
+ * pairs adds 2 to it and 1 to FinalExp. MSMPoints counts the terms of every
+ * multi-scalar multiplication. G1Mul also counts the terms of an MSM small
+ * enough to run as separate multiplications, i.e. through msmG1Naive().
+ * FieldInversion counts Fr::inv calls and Fr divisions, and a batch inversion
+ * as one.
+ */
+enum class ProfileCounter {
+    G1Mul,
+    G2Mul,
+    MSMPoints,
+    MillerLoop,
+    FinalExp,
+    FieldInversion,
+    NTT,
+    Count
+};
+
+const char *profileCounterName(ProfileCounter counter);
+
+// Aggregate of every span with the same path, e.g. "proveZeroTest/commit/msm"
+struct ProfileSpanStats {
+    string path;
+    size_t depth;
+    uint64_t calls;
+    uint64_t total_ns;
+    uint64_t self_ns; // total_ns minus the time spent in child spans
+};
+
+struct ProfileSummary {
+    vector<ProfileSpanStats> spans; // Sorted by path, so parents come before their children
+    uint64_t counters[(size_t)ProfileCounter::Count];
+    map<size_t, uint64_t> ntt_sizes; // Transform size to number of transforms
+
+    uint64_t count(ProfileCounter counter) const { return counters[(size_t)counter]; }
+};
+
+/**
+ * @brief Whether the library was built with -DKZG_PROFILE
+ *
+ * Without it the PROFILE_* macros expand to nothing, nothing is recorded and
+ * summaries and traces come back empty.
+ */
+bool profileEnabled();
+
+// Drops all recorded spans and zeroes the counters. Spans still open are not
+// recorded. Safe while other threads record.
+void profileReset();
+
+/**
+ * @brief Aggregates the recorded spans by path, along with the counters
+ *
+ * Spans nest per thread: a span opened inside a parallelFor chunk on a
+ * worker thread starts a new root path on that thread. It may run while other
+ * threads record, spans still open are left out.
+ */
+ProfileSummary profileSummary();
+
+void printProfileSummary(ostream &out, const ProfileSummary &summary);
+
+/**
+ * @brief Exports the recorded spans in the Chrome trace event format
+ *
+ * The output loads in chrome://tracing and Perfetto. Counters go into
+ * otherData. Like profileSummary(), it leaves out spans still open.
+ */
+string chromeTrace();
+
+// Writes chromeTrace() to path, throws runtime_error if the file cannot be written
+void writeChromeTrace(const string &path);
+
+#ifdef KZG_PROFILE
+
+// Records the time between construction and destruction as a span of the calling thread
+class ProfileSpan {
+public:
+    explicit ProfileSpan(const char *name);
+    ~ProfileSpan();
+
+    ProfileSpan(const ProfileSpan &) = delete;
+    ProfileSpan &operator=(const ProfileSpan &) = delete;
+
+private:
+    size_t index;
+    uint64_t generation;
+};
+
+void profileCount(ProfileCounter counter, uint64_t n = 1);
+
+// Counts count NTTs of the given size, also adds count to ProfileCounter::NTT
+void profileNTT(size_t size, uint64_t count = 1);
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+// name must outlive the profiler data, in practice a string literal
+#define PROFILE_SPAN(name) ProfileSpan PROFILE_CONCAT(profile_span_, __LINE__)(name)
+#define PROFILE_COUNT(counter, n) profileCount(ProfileCounter::counter, n)
+#define PROFILE_NTT(size, count) profileNTT(size, count)
+
+#else
+
+#define PROFILE_SPAN(name) ((void)0)
+#define PROFILE_COUNT(counter, n) ((void)0)
+#define PROFILE_NTT(size, count) ((void)0)
+
+#endif
+
+#endif // PROFILE_H
@@ -0,0 +1,345 @@
+#include "srs.h"
+#include "../msm/msm.h"
+#include "../parallel/parallel.h"
+#include "../profile/profile.h"
+#include <mcl/bn.hpp>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace mcl;
+using namespace bn;
+
+static const char SRS_MAGIC[8] = {'K', 'Z', 'G', 'S', 'R', 'S', 0, 0};
+
+// Number of points encoded per buffered write in saveSRS()
+static const size_t SRS_WRITE_BLOCK = 1 << 16;
+
+struct SRSHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t encoding;
+    uint64_t t;
+    uint64_t g1_count;
+    uint64_t g2_count;
+    uint32_t g1_size; // Bytes per encoded G1 point
+    uint32_t g2_size; // Bytes per encoded G2 point
+};
+
+// Private mapping of a whole file, unmapped on destruction. Pages come from the
+// page cache and stay shared with every other process mapping the file until
+// one of them is written, which copies just that page.
+struct MappedFile {
+    uint8_t *data;
+    size_t size;
+
+    explicit MappedFile(const string &path) : data(nullptr), size(0) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw runtime_error("Cannot open SRS file: " + path);
+
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            throw runtime_error("Cannot stat SRS file: " + path);
+        }
+        size = st.st_size;
+
+        if (size > 0) {
+            void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                close(fd);
+                throw runtime_error("Cannot map SRS file: " + path);
+            }
+            data = static_cast<uint8_t *>(p);
+        }
+        close(fd);
+    }
+
+    ~MappedFile() {
+        if (data) munmap(data, size);
+    }
+
+private:
+    MappedFile(const MappedFile &);
+    MappedFile &operator=(const MappedFile &);
+};
+
+template <class G>
+static size_t encodePoint(uint8_t *buf, size_t max_size, const G &P, SRSEncoding encoding) {
+    if (encoding == SRSEncoding::Raw) {
+        if (max_size < sizeof(G)) return 0;
+        memcpy(buf, &P, sizeof(G));
+        return sizeof(G);
+    }
+
+    int mode = encoding == SRSEncoding::Compressed ? IoSerialize : IoEcAffineSerialize;
+    return P.serialize(buf, max_size, mode);
+}
+
+// Raw points are not decoded, see rawPoints(). mcl may still check the order
+// on deserialize, as set process-wide by verifyOrderG1()/verifyOrderG2().
+template <class G>
+static bool decodePoint(G &P, const uint8_t *buf, size_t size, SRSEncoding encoding, bool check) {
+    int mode = encoding == SRSEncoding::Compressed ? IoSerialize : IoEcAffineSerialize;
+    if (P.deserialize(buf, size, mode) != size) return false;
+    return !check || P.isValidOrder();
+}
+
+template <class G>
+static void writePoints(FILE *fp, const PointArray<G> &points, size_t point_size, SRSEncoding encoding) {
+    vector<uint8_t> buf(min(points.size(), SRS_WRITE_BLOCK) * point_size);
+
+    for (size_t start = 0; start < points.size(); start += SRS_WRITE_BLOCK) {
+        size_t count = min(SRS_WRITE_BLOCK, points.size() - start);
+        atomic<bool> ok(true);
+
+        parallelFor(count, [&](size_t begin, size_t end, size_t) {
+            for (size_t i = begin; i < end; i++) {
+                if (encodePoint(&buf[i * point_size], point_size, points[start + i], encoding) != point_size) ok = false;
+            }
+        }, 0, 1024);
+
+        if (!ok) throw runtime_error("Failed to encode SRS point");
+        if (fwrite(buf.data(), point_size, count, fp) != count) throw runtime_error("Failed to write SRS file");
+    }
+}
+
+template <class G>
+static bool readPoints(PointArray<G> &points, const uint8_t *src, size_t point_size, SRSEncoding encoding, bool check) {
+    atomic<bool> ok(true);
+
+    parallelFor(points.size(), [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end && ok; i++) {
+            if (!decodePoint(points[i], src + i * point_size, point_size, encoding, check)) ok = false;
+        }
+    }, 0, 1024);
+
+    return ok;
+}
+
+// Checks that g1 and g2 hold consecutive powers of one tau. With a random r,
+// e(sum r^i g1[i+1], g) == e(sum r^i g1[i], g^a) holds for all i at once
+// except with negligible probability.
+static bool checkPowers(const KZG::PublicKey &pk) {
+    PROFILE_SPAN("checkPowers");
+    if (pk.g1.empty() || pk.g2.size() < 2 || pk.g1[0].isZero() || pk.g2[0].isZero()) return false;
+
+    Fr r;
+    r.setByCSPRNG();
+
+    size_t n = pk.g1.size() - 1;
+    vector<Fr> rs(max(n, pk.g2.size()));
+    Fr power = 1;
+    for (auto &x : rs) {
+        x = power;
+        power *= r;
+    }
+
+    GT left, right;
+    if (n > 0) {
+        G1 lo, hi;
+        msmG1(lo, pk.g1.data(), rs.data(), n);
+        msmG1(hi, pk.g1.data() + 1, rs.data(), n);
+        PROFILE_COUNT(MillerLoop, 2);
+        PROFILE_COUNT(FinalExp, 2);
+        pairing(left, hi, pk.g2[0]);
+        pairing(right, lo, pk.g2[1]);
+        if (left != right) return false;
+    }
+
+    // Extra G2 powers, e(g1[1], sum r^i g2[i]) == e(g1[0], sum r^i g2[i+1])
+    if (pk.g2.size() > 2 && pk.g1.size() > 1) {
+        G2 lo, hi;
+        lo.clear();
+        hi.clear();
+        PROFILE_COUNT(G2Mul, 2 * (pk.g2.size() - 1));
+        PROFILE_COUNT(MillerLoop, 2);
+        PROFILE_COUNT(FinalExp, 2);
+        for (size_t i = 0; i + 1 < pk.g2.size(); i++) {
+            G2 temp;
+            G2::mul(temp, pk.g2[i], rs[i]);
+            G2::add(lo, lo, temp);
+            G2::mul(temp, pk.g2[i + 1], rs[i]);
+            G2::add(hi, hi, temp);
+        }
+        pairing(left, pk.g1[1], lo);
+        pairing(right, pk.g1[0], hi);
+        if (left != right) return false;
+    }
+
+    return true;
+}
+
+// Subgroup checks of every point, the per-point part of SRSValidation::Full
+template <class G>
+static bool checkPoints(const PointArray<G> &points) {
+    atomic<bool> ok(true);
+
+    parallelFor(points.size(), [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end && ok; i++) {
+            if (!points[i].isValid() || !points[i].isValidOrder()) ok = false;
+        }
+    }, 0, 1024);
+
+    return ok;
+}
+
+void saveSRS(const KZG::PublicKey &pk, const string &path, SRSEncoding encoding) {
+    if (pk.g1.empty() || pk.g2.empty()) throw runtime_error("Cannot save an empty SRS");
+
+    SRSHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SRS_MAGIC, sizeof(SRS_MAGIC));
+    header.version = SRS_VERSION;
+    header.encoding = static_cast<uint32_t>(encoding);
+    header.t = pk.t;
+    header.g1_count = pk.g1.size();
+    header.g2_count = pk.g2.size();
+
+    // All points of a group encode to the same size, measure it on the first one
+    uint8_t probe[1024];
+    header.g1_size = encodePoint(probe, sizeof(probe), pk.g1[0], encoding);
+    header.g2_size = encodePoint(probe, sizeof(probe), pk.g2[0], encoding);
+    if (header.g1_size == 0 || header.g2_size == 0) throw runtime_error("Failed to encode SRS point");
+
+    // Written beside path and renamed over it, so keys still mapping the old
+    // file keep reading it instead of a truncated one
+    const string partial = path + ".partial";
+    FILE *fp = fopen(partial.c_str(), "wb");
+    if (!fp) throw runtime_error("Cannot create SRS file: " + path);
+
+    try {
+        if (fwrite(&header, sizeof(header), 1, fp) != 1) throw runtime_error("Failed to write SRS file");
+        writePoints(fp, pk.g1, header.g1_size, encoding);
+        writePoints(fp, pk.g2, header.g2_size, encoding);
+    } catch (...) {
+        fclose(fp);
+        remove(partial.c_str());
+        throw;
+    }
+
+    if (fclose(fp) != 0 || rename(partial.c_str(), path.c_str()) != 0) {
+        remove(partial.c_str());
+        throw runtime_error("Failed to write SRS file");
+    }
+}
+
+// Raw points are used in place, the array keeps the mapping alive. A copy is
+// made only if the mapping is not aligned for G.
+template <class G>
+static PointArray<G> rawPoints(const shared_ptr<MappedFile> &file, size_t offset, size_t count) {
+    uint8_t *src = file->data + offset;
+    if (reinterpret_cast<uintptr_t>(src) % alignof(G) == 0) return PointArray<G>(file, reinterpret_cast<G *>(src), count);
+
+    PointArray<G> points;
+    points.resize(count);
+    memcpy(points.data(), src, count * sizeof(G));
+    return points;
+}
+
+KZG::PublicKey loadSRS(const string &path, SRSValidation validation) {
+    shared_ptr<MappedFile> file = make_shared<MappedFile>(path);
+
+    SRSHeader header;
+    if (file->size < sizeof(header)) throw runtime_error("SRS file is truncated");
+    memcpy(&header, file->data, sizeof(header));
+
+    if (memcmp(header.magic, SRS_MAGIC, sizeof(SRS_MAGIC)) != 0) throw runtime_error("Not an SRS file");
+    if (header.version != SRS_VERSION) throw runtime_error("Unsupported SRS version");
+    if (header.encoding > static_cast<uint32_t>(SRSEncoding::Raw)) throw runtime_error("Unknown SRS encoding");
+
+    SRSEncoding encoding = static_cast<SRSEncoding>(header.encoding);
+    if (encoding == SRSEncoding::Raw && (header.g1_size != sizeof(G1) || header.g2_size != sizeof(G2))) {
+        throw runtime_error("Raw SRS was written by an incompatible mcl build");
+    }
+    if (header.g1_count == 0 || header.g2_count == 0 || header.g1_size == 0 || header.g2_size == 0) {
+        throw runtime_error("SRS file is malformed");
+    }
+
+    // Bound the counts by the bytes present before multiplying, so a crafted
+    // header cannot wrap the sizes around
+    size_t payload = file->size - sizeof(header);
+    if (header.g1_count > payload / header.g1_size) throw runtime_error("SRS file size does not match header");
+    size_t g1_bytes = header.g1_count * header.g1_size;
+    if (header.g2_count > (payload - g1_bytes) / header.g2_size) throw runtime_error("SRS file size does not match header");
+    size_t g2_bytes = header.g2_count * header.g2_size;
+    if (file->size != sizeof(header) + g1_bytes + g2_bytes) throw runtime_error("SRS file size does not match header");
+
+    KZG::PublicKey pk;
+    pk.t = header.t;
+
+    bool check = validation == SRSValidation::Full;
+    bool valid;
+    if (encoding == SRSEncoding::Raw) {
+        pk.g1 = rawPoints<G1>(file, sizeof(header), header.g1_count);
+        pk.g2 = rawPoints<G2>(file, sizeof(header) + g1_bytes, header.g2_count);
+        valid = !check || (checkPoints(pk.g1) && checkPoints(pk.g2));
+    } else {
+        pk.g1.resize(header.g1_count);
+        pk.g2.resize(header.g2_count);
+
+        const uint8_t *src = file->data + sizeof(header);
+        valid = readPoints(pk.g1, src, header.g1_size, encoding, check) &&
+            readPoints(pk.g2, src + g1_bytes, header.g2_size, encoding, check);
+    }
+    if (!valid) throw runtime_error("SRS file contains an invalid point");
+
+    if (check && !checkPowers(pk)) throw runtime_error("SRS points are not consecutive powers of tau");
+
+    prepareVerifier(pk);
+    return pk;
+}
+
+// One version of one file: rewriting it changes the modification time or
+// size, replacing it by rename changes the inode
+typedef tuple<string, uint64_t, uint64_t, int64_t, int64_t, int64_t> FileIdentity;
+
+static FileIdentity fileIdentity(const string &path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) throw runtime_error("Cannot open SRS file: " + path);
+    return FileIdentity(path, st.st_dev, st.st_ino, st.st_mtim.tv_sec, st.st_mtim.tv_nsec, st.st_size);
+}
+
+struct CachedKey {
+    weak_ptr<const KZG::PublicKey> key;
+    SRSValidation validation; // Checks the cached key has passed
+};
+
+KZG::SRSHandle openSRS(const string &path, SRSValidation validation) {
+    static mutex lock;
+    static map<FileIdentity, CachedKey> open_keys;
+
+    lock_guard<mutex> guard(lock);
+    for (auto it = open_keys.begin(); it != open_keys.end();) {
+        if (it->second.key.expired()) it = open_keys.erase(it);
+        else ++it;
+    }
+
+    FileIdentity id = fileIdentity(path);
+    auto it = open_keys.find(id);
+    if (it == open_keys.end()) {
+        KZG::SRSHandle handle = shareKey(loadSRS(path, validation));
+        open_keys[id] = CachedKey{handle, validation};
+        return handle;
+    }
+
+    // A key loaded as Trusted gets the full checks before it is handed out as Full
+    KZG::SRSHandle handle = it->second.key.lock();
+    if (validation == SRSValidation::Full && it->second.validation != SRSValidation::Full) {
+        if (!checkPoints(handle->g1) || !checkPoints(handle->g2)) throw runtime_error("SRS file contains an invalid point");
+        if (!checkPowers(*handle)) throw runtime_error("SRS points are not consecutive powers of tau");
+        it->second.validation = SRSValidation::Full;
+    }
+    return handle;
+}
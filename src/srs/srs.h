@@ -0,0 +1,81 @@
+#ifndef SRS_H
+#define SRS_H
+
+#include <mcl/bn.hpp>
+#include <string>
+#include <cstdint>
+#include "../kzg/kzg.h"
+
+using namespace mcl;
+using namespace bn;
+using namespace std;
+
+// Current on-disk SRS format version
+static const uint32_t SRS_VERSION = 1;
+
+/**
+ * @brief Point encoding used for the g1/g2 arrays of an SRS file
+ *
+ * Compressed stores x plus a sign bit and needs a square root per point on
+ * load. Uncompressed stores affine x and y. Raw stores mcl's in-memory point
+ * layout, which the loaded key reads straight from the mapping, but it is only
+ * readable by a build with the same mcl configuration.
+ */
+enum class SRSEncoding : uint32_t {
+    Compressed = 0,
+    Uncompressed = 1,
+    Raw = 2
+};
+
+/**
+ * @brief How much checking loadSRS() does on the points it reads
+ *
+ * Full checks every point for subgroup membership and checks that g1/g2 are
+ * consecutive powers of the same tau with a randomized pairing test. Trusted
+ * only decodes, for files produced by our own setup(). mcl's own order check
+ * on deserialize follows the process-wide verifyOrderG1()/verifyOrderG2()
+ * setting in both modes, loadSRS() never changes it.
+ */
+enum class SRSValidation {
+    Full,
+    Trusted
+};
+
+/**
+ * @brief Writes the public key to a versioned SRS file
+ * @param pk Public key to store
+ * @param path Output file path
+ * @param encoding Point encoding for the g1/g2 arrays
+ */
+void saveSRS(const KZG::PublicKey &pk, const string &path, SRSEncoding encoding = SRSEncoding::Uncompressed);
+
+/**
+ * @brief Memory-maps an SRS file read-only and decodes it into a public key
+ * @param path Path of a file written by saveSRS()
+ * @param validation Full subgroup/structure checks or trusted fast loading
+ * @return The decoded public key
+ *
+ * Throws runtime_error if the file is malformed or fails validation.
+ * Decoding is split across getThreadCount() threads. A Raw file is not
+ * decoded: the key's g1/g2 arrays point into the mapping and keep it alive,
+ * so processes loading the same file share its pages. saveSRS() replaces the
+ * file by rename, so rewriting it never disturbs a key still mapping it.
+ */
+KZG::PublicKey loadSRS(const string &path, SRSValidation validation = SRSValidation::Full);
+
+/**
+ * @brief Returns a shared handle to the SRS stored at path
+ * @param path Path of a file written by saveSRS()
+ * @param validation Checks done if the file has to be loaded
+ * @return Handle shared with every other live handle opened from the same file
+ *
+ * The file is loaded once while any handle to it is alive, so concurrent
+ * provers share one copy of the key instead of each holding their own. The
+ * cache is keyed by the file's device, inode, modification time and size, so
+ * a rewritten or replaced file is loaded again. A key first opened as Trusted
+ * is fully validated before it is returned for a Full open, which throws if
+ * the checks fail.
+ */
+KZG::SRSHandle openSRS(const string &path, SRSValidation validation = SRSValidation::Full);
+
+#endif // SRS_H
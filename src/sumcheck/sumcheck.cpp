@@ -2,79 +2,140 @@
 #include "../zerotest/zerotest.h"
 #include "../kzg/kzg.h"
 #include "../ntt/ntt.h"
+#include "../profile/profile.h"
 #include <mcl/bn.hpp>
 #include <cassert>
+#include <algorithm>
 
 using namespace std;
 using namespace mcl;
 using namespace bn;
 
-void outputTiming(milliseconds prover_time, milliseconds verifier_time) {
+void outputTiming(nanoseconds prover_time, nanoseconds verifier_time) {
     cout << "\nRunning SumCheck...\n";
-    cout << "Prover time: " << fixed << setprecision(3) << prover_time.count() / 1000.0 << " seconds" << endl;
-    cout << "Verifier time: " << fixed << setprecision(3) << verifier_time.count() / 1000.0 << " seconds" << endl;
+    cout << "Prover time: " << fixed << setprecision(6) << prover_time.count() / 1e9 << " seconds" << endl;
+    cout << "Verifier time: " << fixed << setprecision(6) << verifier_time.count() / 1e9 << " seconds" << endl;
 }
 
-// Proof size is O(1) as there is constant number of communication.
-bool sumCheck(KZG::PublicKey pk, vector<Fr> q, Fr w, size_t l, Fr s) {  
-    auto start_time = high_resolution_clock::now();
-
-    milliseconds prover_time = duration_cast<milliseconds>(start_time - start_time);
-    milliseconds verifier_time = duration_cast<milliseconds>(start_time - start_time);  
-
-    // Prover's evaluation
-    // Since zh(x) = x^l - 1, polynomialDivision is O(D)F
-    startTime(start_time);
-    vector<Fr> p = q; // Remainder
-    p[0] -= s / l;
+// Challenge r = H(l, s, comm_q, comm_f, comm_p), identical on both sides. The
+// transcript then goes on to derive the batch opening challenge.
+static Fr sumCheckChallenge(Transcript &transcript, const KZG::Commitment &comm_q, const SumCheckProof &proof, size_t l, const Fr &s) {
+    transcript.absorb("l", (uint64_t)l);
+    transcript.absorb("s", s);
+    transcript.absorb("comm_q", comm_q.c);
+    transcript.absorb("comm_f", proof.comm_f.c);
+    transcript.absorb("comm_p", proof.comm_p.c);
+    return transcript.challenge("r");
+}
 
-    vector<Fr> f = polynomialDivision(p, l);
+SumCheckProof proveSumCheck(const KZG::PublicKey &pk, PolyView q, const KZG::Commitment &comm_q, size_t l, const Fr &s) {
+    PROFILE_SPAN("proveSumCheck");
 
-    // Check if p is correct remainder i.e. degree < n-1 
-    while (!p.empty() && p.back().isZero()) {
-        p.pop_back();
-    }
+    // Since zh(x) = x^l - 1, the division is O(D)F
+    ArenaScope scratch;
+    size_t f_size = vanishingQuotientSize(q.size, l);
+    Fr *f_data = scratch.allocFr(f_size);
+    vanishingQuotient(q, l, f_data);
+    PolyView f(f_data, f_size);
 
-    if ((!p.empty() && p[0] != 0) || p.size() > l) {
-        outputTiming(prover_time, verifier_time); 
+    // The remainder has r[j] = q[j] + f[j] for j < l, and r(0) must be s/l
+    PROFILE_COUNT(FieldInversion, 1);
+    Fr r0 = (q.empty() ? Fr(0) : q[0]) + f[0] - s / l;
+    if (r0 != 0) {
         throw runtime_error("Wrong remainder!");
     }
 
-    if (!p.empty()) p.erase(p.begin());
-    else p.push_back(0);
+    // p = (r - s/l) / x, read straight from q and f without copying q
+    size_t p_size = max(l, (size_t)2) - 1;
+    Fr *p_data = scratch.allocFr(p_size);
+    for (size_t j = 1; j < l; j++) {
+        if (j < q.size) p_data[j - 1] += q[j];
+        if (j < f.size) p_data[j - 1] += f[j];
+    }
+    PolyView p(p_data, p_size);
     
-    KZG::Commitment comm_f = commit(pk, f); // O(D)G
-    KZG::Commitment comm_q = commit(pk, q); // O(D)G
-    KZG::Commitment comm_p = commit(pk, p); // O(D)G
-    endTime(prover_time, start_time);
+    SumCheckProof proof;
+    proof.comm_f = commit(pk, f); // O(D)G
+    proof.comm_p = commit(pk, p); // O(D)G
 
-    // Prover sends comm_f and comm_q to Verifier
-    // Verifier sends random challenge r to Prover
-    startTime(start_time);
-    Fr r;
-    r.setByCSPRNG();
-    endTime(verifier_time, start_time);
+    // Fiat-Shamir replaces the verifier's random challenge r
+    Transcript transcript("sumcheck");
+    Fr r = sumCheckChallenge(transcript, comm_q, proof, l, s);
 
-    // Prover creates witnesses to f(r) and q(r)
-    startTime(start_time);
-    KZG::Witness witness_f = createWitness(pk, f, r); // Witness to fr --> O(D)G
-    KZG::Witness witness_q = createWitness(pk, q, r); // Witness to qr --> O(D)G
-    KZG::Witness witness_p = createWitness(pk, p, r); // Witness to qr --> O(D)G
-    endTime(prover_time, start_time);
+    // Single witness to qr, fr and pr --> O(D)G
+    proof.opening = createBatchWitness(pk, {q, f, p}, r, transcript);
 
-    // Prover sends to Verifier: witness_f, witness_q, witness_p
+    return proof;
+}
+
+bool verifySumCheck(const KZG::PublicKey &pk, const KZG::Commitment &comm_q, const SumCheckProof &proof, size_t l, const Fr &s) {
+    PROFILE_SPAN("verifySumCheck");
+    if (proof.opening.qi.size() != 3) return false;
+
+    Transcript transcript("sumcheck");
+    Fr r = sumCheckChallenge(transcript, comm_q, proof, l, s);
 
     // Public knowledge --> Both Prover and Verifier can evaluate Zh(r) in O(1)F
-    startTime(start_time);
     Fr zr;
     Fr::pow(zr, r, l);
     zr -= 1;
     
-    // Verifier's evaluation
-    // V checks if the commitment and witness open to f(r) and q(r) --> O(1)G
-    // V also checks that the evaluated qr = fr * zr --> O(1)G
-    bool succeed = verifyEval(pk, comm_f, r, witness_f) && verifyEval(pk, comm_q, r, witness_q) 
-        && verifyEval(pk, comm_p, r, witness_p) && witness_q.qi == witness_f.qi * zr + s / l + r * witness_p.qi;
+    // V checks if the commitments and witness open to q(r), f(r) and p(r) --> O(1)G
+    // V also checks that qr = fr * zr + s/l + r * pr --> O(1)F
+    const Fr &qr = proof.opening.qi[0], &fr = proof.opening.qi[1], &pr = proof.opening.qi[2];
+    PROFILE_COUNT(FieldInversion, 1);
+    Fr mean = s / l;
+    return verifyBatchEval(pk, {comm_q, proof.comm_f, proof.comm_p}, r, proof.opening, transcript)
+        && qr == fr * zr + mean + r * pr;
+}
+
+vector<uint8_t> serializeSumCheckProof(const SumCheckProof &proof) {
+    // The opening point is the challenge, so it is not stored
+    ProofWriter writer;
+    writer.write(proof.comm_f.c);
+    writer.write(proof.comm_p.c);
+    writer.write(proof.opening.w);
+    for (const auto &v : proof.opening.qi) writer.write(v);
+    return writer.bytes();
+}
+
+SumCheckProof deserializeSumCheckProof(const vector<uint8_t> &bytes) {
+    ProofReader reader(bytes);
+    SumCheckProof proof;
+    reader.read(proof.comm_f.c);
+    reader.read(proof.comm_p.c);
+    reader.read(proof.opening.w);
+    proof.opening.qi.resize(3);
+    for (auto &v : proof.opening.qi) reader.read(v);
+    if (!reader.done()) throw runtime_error("Malformed proof: trailing bytes.");
+
+    proof.opening.i = 0;
+    return proof;
+}
+
+// Proof size is O(1) as there is constant number of communication.
+bool sumCheck(const KZG::PublicKey &pk, PolyView q, const Fr &w, size_t l, const Fr &s) {  
+    auto start_time = high_resolution_clock::now();
+
+    nanoseconds prover_time = duration_cast<nanoseconds>(start_time - start_time);
+    nanoseconds verifier_time = duration_cast<nanoseconds>(start_time - start_time);  
+
+    // Prover commits to q, computes f and the remainder, commits to f and p and opens all three at r
+    startTime(start_time);
+    KZG::Commitment comm_q = commit(pk, q);
+    SumCheckProof proof;
+    try {
+        proof = proveSumCheck(pk, q, comm_q, l, s);
+    } catch (const runtime_error &) {
+        endTime(prover_time, start_time);
+        outputTiming(prover_time, verifier_time); 
+        throw;
+    }
+    endTime(prover_time, start_time);
+
+    // Prover sends to Verifier: comm_q, then comm_f, comm_p and the batch opening
+    startTime(start_time);
+    bool succeed = verifySumCheck(pk, comm_q, proof, l, s);
     endTime(verifier_time, start_time);
     
     outputTiming(prover_time, verifier_time); 
@@ -4,11 +4,33 @@
 #include <mcl/bn.hpp>
 #include "../kzg/kzg.h"
 #include "../ntt/ntt.h"
+#include "../transcript/transcript.h"
 
 using namespace mcl;
 using namespace bn;
 using namespace std;
 
-bool sumCheck(KZG::PublicKey pk, vector<Fr> q, Fr w, size_t l, Fr s);
+// Non-interactive SumCheck proof for a commitment comm_q the verifier already
+// holds. r is re-derived from comm_q and the proof's commitments.
+struct SumCheckProof {
+    KZG::Commitment comm_f;
+    KZG::Commitment comm_p;
+    // Opening of q, f = (q - s/l) / Z_H and p = remainder / x at r, in that order
+    KZG::BatchWitness opening;
+};
+
+bool sumCheck(const KZG::PublicKey &pk, PolyView q, const Fr &w, size_t l, const Fr &s);
+
+// Prover side with a Fiat-Shamir challenge, comm_q must be commit(pk, q).
+// Throws if q does not sum to s on H.
+SumCheckProof proveSumCheck(const KZG::PublicKey &pk, PolyView q, const KZG::Commitment &comm_q, size_t l, const Fr &s);
+
+// Checks that the polynomial committed in comm_q sums to s on H
+bool verifySumCheck(const KZG::PublicKey &pk, const KZG::Commitment &comm_q, const SumCheckProof &proof, size_t l, const Fr &s);
+
+vector<uint8_t> serializeSumCheckProof(const SumCheckProof &proof);
+
+// Throws runtime_error on malformed input
+SumCheckProof deserializeSumCheckProof(const vector<uint8_t> &bytes);
 
 #endif // SUMCHECK_H
@@ -0,0 +1,94 @@
+#include "transcript.h"
+#include <mcl/bn.hpp>
+#include <openssl/evp.h>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+using namespace mcl;
+using namespace bn;
+
+// Large enough for any compressed point or field element of the curve
+static const size_t MAX_ELEMENT_SIZE = 128;
+
+static void sha256(uint8_t out[32], const vector<uint8_t> &data) {
+    unsigned int size = 0;
+    if (!EVP_Digest(data.data(), data.size(), out, &size, EVP_sha256(), nullptr) || size != 32) {
+        throw runtime_error("SHA-256 failed.");
+    }
+}
+
+// Appends the label length, the label and the message to the state and hashes
+static void mix(uint8_t state[32], const string &label, const uint8_t *data, size_t size) {
+    vector<uint8_t> input(state, state + 32);
+
+    uint64_t label_size = label.size();
+    input.insert(input.end(), (const uint8_t *)&label_size, (const uint8_t *)&label_size + sizeof(label_size));
+    input.insert(input.end(), label.begin(), label.end());
+    input.insert(input.end(), data, data + size);
+
+    sha256(state, input);
+}
+
+Transcript::Transcript(const string &label) {
+    memset(state, 0, sizeof(state));
+    mix(state, "transcript", (const uint8_t *)label.data(), label.size());
+}
+
+void Transcript::absorb(const string &label, const uint8_t *data, size_t size) {
+    mix(state, label, data, size);
+}
+
+void Transcript::absorb(const string &label, const G1 &P) {
+    uint8_t buf[MAX_ELEMENT_SIZE];
+    size_t n = P.serialize(buf, sizeof(buf));
+    if (n == 0) throw runtime_error("Failed to serialize G1 point.");
+    absorb(label, buf, n);
+}
+
+void Transcript::absorb(const string &label, const Fr &x) {
+    uint8_t buf[MAX_ELEMENT_SIZE];
+    size_t n = x.serialize(buf, sizeof(buf));
+    if (n == 0) throw runtime_error("Failed to serialize field element.");
+    absorb(label, buf, n);
+}
+
+void Transcript::absorb(const string &label, uint64_t x) {
+    absorb(label, (const uint8_t *)&x, sizeof(x));
+}
+
+Fr Transcript::challenge(const string &label) {
+    mix(state, "challenge/" + label, nullptr, 0);
+
+    Fr c;
+    c.setHashOf(state, sizeof(state));
+    return c;
+}
+
+void ProofWriter::write(const G1 &P) {
+    uint8_t tmp[MAX_ELEMENT_SIZE];
+    size_t n = P.serialize(tmp, sizeof(tmp));
+    if (n == 0) throw runtime_error("Failed to serialize G1 point.");
+    buf.insert(buf.end(), tmp, tmp + n);
+}
+
+void ProofWriter::write(const Fr &x) {
+    uint8_t tmp[MAX_ELEMENT_SIZE];
+    size_t n = x.serialize(tmp, sizeof(tmp));
+    if (n == 0) throw runtime_error("Failed to serialize field element.");
+    buf.insert(buf.end(), tmp, tmp + n);
+}
+
+ProofReader::ProofReader(const vector<uint8_t> &bytes) : buf(bytes), pos(0) {}
+
+void ProofReader::read(G1 &P) {
+    size_t n = P.deserialize(buf.data() + pos, buf.size() - pos);
+    if (n == 0) throw runtime_error("Malformed proof: invalid G1 point.");
+    pos += n;
+}
+
+void ProofReader::read(Fr &x) {
+    size_t n = x.deserialize(buf.data() + pos, buf.size() - pos);
+    if (n == 0) throw runtime_error("Malformed proof: invalid field element.");
+    pos += n;
+}
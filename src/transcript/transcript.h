@@ -0,0 +1,79 @@
+#ifndef TRANSCRIPT_H
+#define TRANSCRIPT_H
+
+#include <mcl/bn.hpp>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+using namespace mcl;
+using namespace bn;
+using namespace std;
+
+/**
+ * @brief Fiat-Shamir transcript over SHA-256
+ *
+ * Keeps a running 32-byte state. Every absorbed message is hashed into the
+ * state together with its label, and challenges are derived from the state
+ * and then absorbed themselves. Prover and verifier that absorb the same
+ * messages in the same order get the same challenges.
+ */
+class Transcript {
+public:
+    /**
+     * @brief Starts a transcript bound to a protocol label
+     * @param label Domain separator, e.g. the protocol name
+     */
+    explicit Transcript(const string &label);
+
+    void absorb(const string &label, const uint8_t *data, size_t size);
+    void absorb(const string &label, const G1 &P);
+    void absorb(const string &label, const Fr &x);
+    void absorb(const string &label, uint64_t x);
+
+    /**
+     * @brief Derives a field challenge from everything absorbed so far
+     * @param label Name of the challenge
+     * @return The challenge, which is also absorbed into the state
+     */
+    Fr challenge(const string &label);
+
+private:
+    uint8_t state[32];
+};
+
+/**
+ * @brief Appends compact binary encodings of group and field elements
+ *
+ * G1 points use mcl's compressed encoding, field elements their canonical
+ * little-endian bytes.
+ */
+class ProofWriter {
+public:
+    void write(const G1 &P);
+    void write(const Fr &x);
+    const vector<uint8_t> &bytes() const { return buf; }
+
+private:
+    vector<uint8_t> buf;
+};
+
+/**
+ * @brief Reads back what ProofWriter wrote
+ *
+ * Throws runtime_error on truncated input or an invalid encoding.
+ */
+class ProofReader {
+public:
+    explicit ProofReader(const vector<uint8_t> &bytes);
+
+    void read(G1 &P);
+    void read(Fr &x);
+    bool done() const { return pos == buf.size(); }
+
+private:
+    const vector<uint8_t> &buf;
+    size_t pos;
+};
+
+#endif // TRANSCRIPT_H
@@ -1,8 +1,12 @@
 #include "zerotest.h"
 #include "../kzg/kzg.h"
 #include "../ntt/ntt.h"
+#include "../msm/msm.h"
+#include "../parallel/parallel.h"
+#include "../profile/profile.h"
 #include <mcl/bn.hpp>
 #include <cassert>
+#include <algorithm>
 #include <chrono>
 #include <iomanip>
 
@@ -33,69 +37,260 @@ vector<Fr> polynomialDivision(vector<Fr> &a, size_t n) {
     return quotient;
 }
 
+void vanishingQuotient(PolyView q, size_t n, Fr *quotient) {
+    PROFILE_SPAN("vanishingQuotient");
+    size_t size = vanishingQuotientSize(q.size, n);
+    if (q.size <= n) {
+        quotient[0] = 0;
+        return;
+    }
+
+    // q[j] = f[j - n] - f[j] + r[j], so f[k] = q[k + n] + f[k + n] from the top down
+    for (size_t k = size; k-- > 0;) {
+        quotient[k] = q[k + n];
+        if (k + n < size) quotient[k] += quotient[k + n];
+    }
+}
+
+vector<Fr> vanishingQuotient(PolyView q, size_t n) {
+    vector<Fr> quotient(vanishingQuotientSize(q.size, n));
+    vanishingQuotient(q, n, quotient.data());
+    return quotient;
+}
+
 void startTime(high_resolution_clock::time_point &start_time) {
     start_time = high_resolution_clock::now();
 }
 
-void endTime(milliseconds &time, high_resolution_clock::time_point &start_time) {
+void endTime(nanoseconds &time, high_resolution_clock::time_point &start_time) {
     auto end_time = high_resolution_clock::now();
-    time += duration_cast<milliseconds>(end_time - start_time);
+    time += duration_cast<nanoseconds>(end_time - start_time);
 }
 
-// Proof size is O(1) as there is constant number of communication.
-bool zeroTest(KZG::PublicKey pk, vector<Fr> q, Fr w, size_t l) {    
-    auto start_time = high_resolution_clock::now();
-    
-    milliseconds prover_time = duration_cast<milliseconds>(start_time - start_time);
-    milliseconds verifier_time = duration_cast<milliseconds>(start_time - start_time);
-
-    // Check if q vanishes on H
-    Fr curr = 1;
-    for (size_t i = 0; i < l; i++) {
-        if (evaluatePoly(q, curr) != 0) throw runtime_error("Polynomial does not vanish on H."); 
-        curr *= w;
+// Challenge r = H(l, comm_q, comm_f), identical on both sides. The transcript
+// then goes on to derive the batch opening challenge.
+static Fr zeroTestChallenge(Transcript &transcript, const KZG::Commitment &comm_q, const ZeroTestProof &proof, size_t l) {
+    transcript.absorb("l", (uint64_t)l);
+    transcript.absorb("comm_q", comm_q.c);
+    transcript.absorb("comm_f", proof.comm_f.c);
+    return transcript.challenge("r");
+}
+
+// q vanishes on H iff its remainder r[j] = q[j] + f[j], j < l, is zero --> O(l)F
+static void checkVanishing(PolyView q, PolyView f, const Fr &w, size_t l) {
+    PROFILE_SPAN("vanishingCheck");
+    Fr wl;
+    Fr::pow(wl, w, l);
+    if (wl != 1) throw runtime_error("w is not an l-th root of unity.");
+
+    for (size_t j = 0; j < min(l, q.size); j++) {
+        Fr r = q[j];
+        if (j < f.size) r += f[j];
+        if (r != 0) throw runtime_error("Polynomial does not vanish on H.");
     }
-    
-    // Prover's evaluation
-    // Since zh(x) = x^l - 1, polynomialDivision is O(D)F
-    startTime(start_time);
-    vector <Fr> remainder = q;
-    vector<Fr> f = polynomialDivision(remainder, l);
-    
-    KZG::Commitment comm_f = commit(pk, f); // O(D)G
-    KZG::Commitment comm_q = commit(pk, q); // O(D)G
-    endTime(prover_time, start_time);
+}
 
-    // Prover sends comm_f and comm_q to Verifier
-    // Verifier sends random challenge r to Prover
-    startTime(start_time);
-    Fr r;
-    r.setByCSPRNG();
-    endTime(verifier_time, start_time);
+ZeroTestProof proveZeroTest(const KZG::PublicKey &pk, PolyView q, const KZG::Commitment &comm_q, const Fr &w, size_t l, VanishingCheck check) {
+    PROFILE_SPAN("proveZeroTest");
 
-    // Prover creates witnesses to f(r) and q(r)
-    startTime(start_time);
-    KZG::Witness witness_f = createWitness(pk, f, r); // Witness to fr --> O(D)G
-    KZG::Witness witness_q = createWitness(pk, q, r); // Witness to qr --> O(D)G
-    endTime(prover_time, start_time);
+    // Since zh(x) = x^l - 1, the division is O(D)F
+    ArenaScope scratch;
+    size_t f_size = vanishingQuotientSize(q.size, l);
+    Fr *f_data = scratch.allocFr(f_size);
+    vanishingQuotient(q, l, f_data);
+    PolyView f(f_data, f_size);
+
+    if (check == VanishingCheck::Full) checkVanishing(q, f, w, l);
+
+    ZeroTestProof proof;
+    proof.comm_f = commit(pk, f); // O(D)G
+
+    // Fiat-Shamir replaces the verifier's random challenge r
+    Transcript transcript("zerotest");
+    Fr r = zeroTestChallenge(transcript, comm_q, proof, l);
+
+    // Single witness to qr and fr --> O(D)G
+    proof.opening = createBatchWitness(pk, {q, f}, r, transcript);
+
+    return proof;
+}
+
+bool verifyZeroTest(const KZG::PublicKey &pk, const KZG::Commitment &comm_q, const ZeroTestProof &proof, size_t l) {
+    PROFILE_SPAN("verifyZeroTest");
+    if (proof.opening.qi.size() != 2) return false;
 
-    // Prover sends to Verifier: witness_f, witness_q
+    Transcript transcript("zerotest");
+    Fr r = zeroTestChallenge(transcript, comm_q, proof, l);
 
     // Public knowledge --> Both Prover and Verifier can evaluate Zh(r) in O(1)F
-    startTime(start_time);
     Fr zr;
     Fr::pow(zr, r, l);
     zr -= 1;
 
-    // Verifier's evaluation
-    // V checks if the commitment and witness open to f(r) and q(r) --> O(1)G
+    // V checks if the commitments and witness open to q(r) and f(r) --> O(1)G
     // V also checks that the evaluated qr = fr * zr --> O(1)G
-    bool succeed = verifyEval(pk, comm_f, r, witness_f) && verifyEval(pk, comm_q, r, witness_q) && witness_q.qi == witness_f.qi * zr;
+    const Fr &qr = proof.opening.qi[0], &fr = proof.opening.qi[1];
+    return verifyBatchEval(pk, {comm_q, proof.comm_f}, r, proof.opening, transcript)
+        && qr == fr * zr;
+}
+
+// Challenge alpha = H(l, k, comm_q_1..k) combines the polynomials, then
+// r = H(..., comm_f) is the opening point. Identical on both sides.
+static Fr zeroTestBatchAlpha(Transcript &transcript, const vector<KZG::Commitment> &comms, size_t l) {
+    transcript.absorb("l", (uint64_t)l);
+    transcript.absorb("k", (uint64_t)comms.size());
+    for (const auto &comm : comms) transcript.absorb("comm_q", comm.c);
+    return transcript.challenge("alpha");
+}
+
+static Fr zeroTestBatchPoint(Transcript &transcript, const ZeroTestBatchProof &proof) {
+    transcript.absorb("comm_f", proof.comm_f.c);
+    return transcript.challenge("r");
+}
+
+static vector<Fr> powersOf(const Fr &alpha, size_t k) {
+    vector<Fr> powers(k);
+    Fr power = 1;
+    for (auto &p : powers) {
+        p = power;
+        power *= alpha;
+    }
+    return powers;
+}
+
+ZeroTestBatchProof proveZeroTestBatch(const KZG::PublicKey &pk, const vector<PolyView> &polys, const vector<KZG::Commitment> &comms, const Fr &w, size_t l, VanishingCheck check) {
+    PROFILE_SPAN("proveZeroTestBatch");
+    if (polys.empty()) throw runtime_error("Need at least one polynomial.");
+    if (comms.size() != polys.size()) throw runtime_error("Need one commitment per polynomial.");
+
+    // The q_k are fixed by their commitments before alpha is drawn
+    ZeroTestBatchProof proof;
+    Transcript transcript("zerotest_batch");
+    Fr alpha = zeroTestBatchAlpha(transcript, comms, l);
+    vector<Fr> powers = powersOf(alpha, polys.size());
+
+    // g = sum_k alpha^k q_k --> O(kD)F, split by coefficient
+    size_t size = 0;
+    for (const auto &q : polys) size = max(size, q.size);
+
+    ArenaScope scratch;
+    Fr *g_data = scratch.allocFr(size);
+    parallelFor(size, [&](size_t begin, size_t end, size_t) {
+        for (size_t k = 0; k < polys.size(); k++) {
+            const PolyView &q = polys[k];
+            for (size_t j = begin; j < min(end, q.size); j++) g_data[j] += powers[k] * q[j];
+        }
+    }, 0, 4096);
+    PolyView g(g_data, size);
+
+    // A single division of g by Zh. Any q_k that does not vanish on H leaves
+    // a nonzero remainder in g except with probability k / |F| over alpha.
+    size_t f_size = vanishingQuotientSize(g.size, l);
+    Fr *f_data = scratch.allocFr(f_size);
+    vanishingQuotient(g, l, f_data);
+    PolyView f(f_data, f_size);
+
+    if (check == VanishingCheck::Full) checkVanishing(g, f, w, l);
+
+    proof.comm_f = commit(pk, f); // O(D)G
+    Fr r = zeroTestBatchPoint(transcript, proof);
+
+    // Single witness to gr and fr --> O(D)G
+    proof.opening = createBatchWitness(pk, {g, f}, r, transcript);
+
+    return proof;
+}
+
+bool verifyZeroTestBatch(const KZG::PublicKey &pk, const vector<KZG::Commitment> &comms, const ZeroTestBatchProof &proof, size_t l) {
+    PROFILE_SPAN("verifyZeroTestBatch");
+    if (comms.empty() || proof.opening.qi.size() != 2) return false;
+
+    Transcript transcript("zerotest_batch");
+    Fr alpha = zeroTestBatchAlpha(transcript, comms, l);
+    Fr r = zeroTestBatchPoint(transcript, proof);
+
+    // C_g = sum_k alpha^k C_k, the only step that grows with k --> one k-term MSM
+    vector<Fr> powers = powersOf(alpha, comms.size());
+    vector<G1> points(comms.size());
+    for (size_t k = 0; k < points.size(); k++) points[k] = comms[k].c;
+    KZG::Commitment comm_g;
+    msmG1(comm_g.c, points.data(), powers.data(), points.size());
+
+    Fr zr;
+    Fr::pow(zr, r, l);
+    zr -= 1;
+
+    // V checks the opening of g and f at r and that gr = fr * zr --> O(1)G
+    const Fr &gr = proof.opening.qi[0], &fr = proof.opening.qi[1];
+    return verifyBatchEval(pk, {comm_g, proof.comm_f}, r, proof.opening, transcript)
+        && gr == fr * zr;
+}
+
+vector<uint8_t> serializeZeroTestProof(const ZeroTestProof &proof) {
+    // The opening point is the challenge, so it is not stored
+    ProofWriter writer;
+    writer.write(proof.comm_f.c);
+    writer.write(proof.opening.w);
+    for (const auto &v : proof.opening.qi) writer.write(v);
+    return writer.bytes();
+}
+
+ZeroTestProof deserializeZeroTestProof(const vector<uint8_t> &bytes) {
+    ProofReader reader(bytes);
+    ZeroTestProof proof;
+    reader.read(proof.comm_f.c);
+    reader.read(proof.opening.w);
+    proof.opening.qi.resize(2);
+    for (auto &v : proof.opening.qi) reader.read(v);
+    if (!reader.done()) throw runtime_error("Malformed proof: trailing bytes.");
+
+    proof.opening.i = 0;
+    return proof;
+}
+
+vector<uint8_t> serializeZeroTestBatchProof(const ZeroTestBatchProof &proof) {
+    // The opening point is the challenge, so it is not stored
+    ProofWriter writer;
+    writer.write(proof.comm_f.c);
+    writer.write(proof.opening.w);
+    for (const auto &v : proof.opening.qi) writer.write(v);
+    return writer.bytes();
+}
+
+ZeroTestBatchProof deserializeZeroTestBatchProof(const vector<uint8_t> &bytes) {
+    ProofReader reader(bytes);
+    ZeroTestBatchProof proof;
+    reader.read(proof.comm_f.c);
+    reader.read(proof.opening.w);
+    proof.opening.qi.resize(2);
+    for (auto &v : proof.opening.qi) reader.read(v);
+    if (!reader.done()) throw runtime_error("Malformed proof: trailing bytes.");
+
+    proof.opening.i = 0;
+    return proof;
+}
+
+// Proof size is O(1) as there is constant number of communication.
+bool zeroTest(const KZG::PublicKey &pk, PolyView q, const Fr &w, size_t l, VanishingCheck check) {    
+    auto start_time = high_resolution_clock::now();
+    
+    nanoseconds prover_time = duration_cast<nanoseconds>(start_time - start_time);
+    nanoseconds verifier_time = duration_cast<nanoseconds>(start_time - start_time);
+
+    // Prover commits to q, computes f = q / Zh, commits to f and opens both at r
+    startTime(start_time);
+    KZG::Commitment comm_q = commit(pk, q);
+    ZeroTestProof proof = proveZeroTest(pk, q, comm_q, w, l, check);
+    endTime(prover_time, start_time);
+
+    // Prover sends to Verifier: comm_q, then comm_f and the batch opening
+    startTime(start_time);
+    bool succeed = verifyZeroTest(pk, comm_q, proof, l);
     endTime(verifier_time, start_time);
 
     cout << "\nRunning ZeroTest...\n";
-    cout << "Prover time: " << fixed << setprecision(3) << prover_time.count() / 1000.0 << " seconds" << endl;
-    cout << "Verifier time: " << fixed << setprecision(3) << verifier_time.count() / 1000.0 << " seconds" << endl;
+    cout << "Prover time: " << fixed << setprecision(6) << prover_time.count() / 1e9 << " seconds" << endl;
+    cout << "Verifier time: " << fixed << setprecision(6) << verifier_time.count() / 1e9 << " seconds" << endl;
 
     return succeed;
 }
@@ -6,18 +6,86 @@
 #include <iomanip>
 #include "../kzg/kzg.h"
 #include "../ntt/ntt.h"
+#include "../transcript/transcript.h"
+#include "../arena/arena.h"
 
 using namespace mcl;
 using namespace bn;
 using namespace std;
 using namespace std::chrono;
 
+/**
+ * @brief Whether the ZeroTest prover checks that q vanishes on H
+ *
+ * Full reduces q mod x^l - 1 in one linear pass and throws unless the
+ * remainder is zero. Skip trusts the caller, a q that does not vanish then
+ * yields a proof the verifier rejects.
+ */
+enum class VanishingCheck {
+    Full,
+    Skip
+};
+
+// Non-interactive ZeroTest proof for a commitment comm_q the verifier already
+// holds. r is re-derived from comm_q and comm_f, so the proof only verifies
+// against the commitment it was made for.
+struct ZeroTestProof {
+    KZG::Commitment comm_f;
+    KZG::BatchWitness opening; // Opening of q and f = q / Z_H at r, in that order
+};
+
+/**
+ * @brief One ZeroTest proof for k committed polynomials that vanish on the same H
+ *
+ * The verifier already holds the commitments C_k to the q_k. They are combined
+ * as g = sum_k alpha^k q_k with a Fiat-Shamir alpha drawn from the C_k, and
+ * only g is divided by Z_H. The verifier folds the C_k into C_g with one MSM
+ * and checks a single two-polynomial opening, so everything but that MSM is
+ * independent of k.
+ */
+struct ZeroTestBatchProof {
+    KZG::Commitment comm_f; // f = g / Z_H
+    KZG::BatchWitness opening; // Opening of g and f at r, in that order
+};
+
 vector<Fr> polynomialDivision(vector<Fr> &a, size_t n);
 
+// Quotient of q by x^n - 1 without copying q, f[k] = sum_{m >= 1} q[k + m n].
+// Writes vanishingQuotientSize(q.size, n) coefficients to quotient.
+void vanishingQuotient(PolyView q, size_t n, Fr *quotient);
+
+inline size_t vanishingQuotientSize(size_t size, size_t n) { return size <= n ? 1 : size - n; }
+
+vector<Fr> vanishingQuotient(PolyView q, size_t n);
+
 void startTime(high_resolution_clock::time_point &start_time);
 
-void endTime(milliseconds &time, high_resolution_clock::time_point &start_time);
+void endTime(nanoseconds &time, high_resolution_clock::time_point &start_time);
+
+bool zeroTest(const KZG::PublicKey &pk, PolyView q, const Fr &w, size_t l, VanishingCheck check = VanishingCheck::Full);
+
+// Prover side with a Fiat-Shamir challenge, comm_q must be commit(pk, q).
+// Throws if the check is on and q does not vanish on H.
+ZeroTestProof proveZeroTest(const KZG::PublicKey &pk, PolyView q, const KZG::Commitment &comm_q, const Fr &w, size_t l, VanishingCheck check = VanishingCheck::Full);
+
+// Checks that the polynomial committed in comm_q vanishes on H
+bool verifyZeroTest(const KZG::PublicKey &pk, const KZG::Commitment &comm_q, const ZeroTestProof &proof, size_t l);
+
+// Prover side of the batched ZeroTest, comms[k] must be commit(pk, polys[k]).
+// Throws if the check is on and some q_k does not vanish on H.
+ZeroTestBatchProof proveZeroTestBatch(const KZG::PublicKey &pk, const vector<PolyView> &polys, const vector<KZG::Commitment> &comms, const Fr &w, size_t l, VanishingCheck check = VanishingCheck::Full);
+
+// Checks that every polynomial committed in comms vanishes on H
+bool verifyZeroTestBatch(const KZG::PublicKey &pk, const vector<KZG::Commitment> &comms, const ZeroTestBatchProof &proof, size_t l);
+
+vector<uint8_t> serializeZeroTestProof(const ZeroTestProof &proof);
+
+// Throws runtime_error on malformed input
+ZeroTestProof deserializeZeroTestProof(const vector<uint8_t> &bytes);
+
+vector<uint8_t> serializeZeroTestBatchProof(const ZeroTestBatchProof &proof);
 
-bool zeroTest(KZG::PublicKey pk, vector<Fr> q, Fr w, size_t l);
+// Throws runtime_error on malformed input
+ZeroTestBatchProof deserializeZeroTestBatchProof(const vector<uint8_t> &bytes);
 
 #endif // ZEROTEST_H
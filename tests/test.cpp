@@ -2,12 +2,21 @@
 #include "kzg.h"
 #include "ntt.h"
 #include "zerotest.h"
+#include "msm.h"
+#include "srs.h"
+#include "parallel.h"
+#include "arena.h"
+#include "polynomial.h"
+#include "multipoint.h"
+#include "profile.h"
 #include <mcl/bn.hpp>
 #include <iostream>
 #include <vector>
 #include <cassert>
 #include <cmath>
 #include <cstdlib>
+#include <cstring>
+#include <cstdio>
 #include <chrono>
 #include <iomanip>
 
@@ -87,6 +96,135 @@ bool testNTT() {
             }
         }
         
+        // Test 3: Cached domain and a non-canonical root against direct evaluation
+        size_t logN = 4, n = 16;
+        const EvaluationDomain &domain = EvaluationDomain::get(logN);
+        Fr omega_3 = domain.omega * domain.omega * domain.omega; // Also primitive, not cached
+        
+        vector<Fr> poly(n);
+        for (size_t i = 0; i < n; i++) poly[i] = rand();
+        vector<Fr> cached = poly, generic = poly;
+        domain.ntt(cached);
+        ntt_transform(generic, omega_3);
+        
+        bool domain_passed = domain.omega == findPrimitiveRoot(n) && domain.size == n;
+        Fr x = 1, y = 1;
+        for (size_t k = 0; k < n && domain_passed; k++) {
+            if (cached[k] != evaluatePoly(poly, x) || generic[k] != evaluatePoly(poly, y)) domain_passed = false;
+            x *= domain.omega;
+            y *= omega_3;
+        }
+        domain.intt(cached);
+        if (cached != poly) domain_passed = false;
+        
+        if (domain_passed) {
+            cout << "✓ Evaluation domain test passed" << endl;
+        } else {
+            cout << "✗ Evaluation domain test failed" << endl;
+            auto end_time = high_resolution_clock::now();
+            auto duration = duration_cast<milliseconds>(end_time - start_time);
+            cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+            return false;
+        }
+        
+        // Test 4: Multi-threaded NTT and every supported kernel must match the single-threaded result exactly
+        size_t large = 1 << 13;
+        Fr omega_large = findPrimitiveRoot(large);
+        vector<Fr> serial(large);
+        for (size_t i = 0; i < large; i++) serial[i] = rand();
+        vector<Fr> threaded = serial, input = serial;
+        
+        size_t saved_threads = getThreadCount();
+        setThreadCount(1);
+        ntt_transform(serial, omega_large);
+        setThreadCount(4);
+        ntt_transform(threaded, omega_large);
+        
+        // Every butterfly kernel this CPU runs must agree with the default one
+        bool kernels_agree = true;
+        for (NttKernel kernel : {NttKernel::Generic, NttKernel::Unrolled, NttKernel::Avx2, NttKernel::Avx512Ifma}) {
+            if (!nttKernelSupported(kernel)) continue;
+            setNttKernel(kernel);
+            vector<Fr> kernel_result = input;
+            ntt_transform(kernel_result, omega_large);
+            if (kernel_result != serial) kernels_agree = false;
+        }
+        setNttKernel(NttKernel::Auto);
+        setThreadCount(saved_threads);
+        
+        if (serial == threaded && kernels_agree) {
+            cout << "✓ Parallel NTT and kernel test passed" << endl;
+        } else {
+            cout << "✗ Parallel NTT and kernel test failed" << endl;
+            auto end_time = high_resolution_clock::now();
+            auto duration = duration_cast<milliseconds>(end_time - start_time);
+            cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+            return false;
+        }
+        
+        // Test 5: Four-step NTT matches the radix-2 transform for even and odd log sizes
+        for (size_t log_size : {6, 7}) {
+            const EvaluationDomain &d = EvaluationDomain::get(log_size);
+            vector<Fr> radix2(d.size);
+            for (auto &x : radix2) x = rand();
+            vector<Fr> input = radix2, four_step = radix2;
+            
+            d.ntt(radix2);
+            d.nttFourStep(four_step);
+            bool four_step_passed = radix2 == four_step;
+            d.inttFourStep(four_step);
+            four_step_passed = four_step_passed && four_step == input;
+            
+            if (four_step_passed) {
+                cout << "✓ Four-step NTT size " << d.size << " test passed" << endl;
+            } else {
+                cout << "✗ Four-step NTT size " << d.size << " test failed" << endl;
+                auto end_time = high_resolution_clock::now();
+                auto duration = duration_cast<milliseconds>(end_time - start_time);
+                cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+                return false;
+            }
+        }
+        
+        // Test 6: Batched and interleaved NTTs match one ntt_transform per polynomial
+        size_t batch_size = 5, poly_size = 32;
+        Fr omega_batch = findPrimitiveRoot(poly_size);
+        vector<vector<Fr>> polys(batch_size, vector<Fr>(poly_size));
+        for (auto &p : polys) {
+            for (auto &x : p) x = rand();
+        }
+        
+        vector<vector<Fr>> batched = polys, expected = polys;
+        vector<Fr> interleaved(batch_size * poly_size);
+        for (size_t i = 0; i < poly_size; i++) {
+            for (size_t p = 0; p < batch_size; p++) interleaved[i * batch_size + p] = polys[p][i];
+        }
+        
+        for (auto &p : expected) ntt_transform(p, omega_batch);
+        ntt_transform_batch(batched, omega_batch);
+        ntt_transform_interleaved(interleaved, batch_size, omega_batch);
+        
+        bool batch_passed = batched == expected;
+        for (size_t i = 0; i < poly_size && batch_passed; i++) {
+            for (size_t p = 0; p < batch_size; p++) {
+                if (interleaved[i * batch_size + p] != expected[p][i]) batch_passed = false;
+            }
+        }
+        
+        ntt_inverse_batch(batched, omega_batch);
+        ntt_inverse_interleaved(interleaved, batch_size, omega_batch);
+        batch_passed = batch_passed && batched == polys && interleaved[3 * batch_size + 2] == polys[2][3];
+        
+        if (batch_passed) {
+            cout << "✓ Batched NTT test passed" << endl;
+        } else {
+            cout << "✗ Batched NTT test failed" << endl;
+            auto end_time = high_resolution_clock::now();
+            auto duration = duration_cast<milliseconds>(end_time - start_time);
+            cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+            return false;
+        }
+        
         cout << "✓ All NTT tests passed!" << endl;
         auto end_time = high_resolution_clock::now();
         auto duration = duration_cast<milliseconds>(end_time - start_time);
@@ -180,6 +318,175 @@ bool testPoly() {
             return false;
         }
         
+        // Test 4: Coset NTT, low-degree extension and pointwise division by x^l - 1
+        size_t l = 4, N = 16;
+        Fr shift = cosetShift(), omega_N = findPrimitiveRoot(N);
+        
+        // numerator = q - (q mod x^l - 1) is divisible by x^l - 1
+        vector<Fr> q(11);
+        for (auto &x : q) x = rand();
+        vector<Fr> remainder = q;
+        vector<Fr> expected_quotient = polynomialDivision(remainder, l);
+        vector<Fr> numerator = q;
+        for (size_t i = 0; i < remainder.size(); i++) numerator[i] -= remainder[i];
+        numerator.resize(N, 0);
+        
+        vector<Fr> evals = numerator;
+        coset_ntt(evals, omega_N, shift);
+        bool coset_passed = evals[3] == evaluatePoly(numerator, shift * omega_N * omega_N * omega_N);
+        
+        divide_by_vanishing_coset(evals, l, shift);
+        coset_intt(evals, omega_N, shift);
+        for (size_t i = 0; i < N; i++) {
+            Fr want = i < expected_quotient.size() ? expected_quotient[i] : Fr(0);
+            if (evals[i] != want) coset_passed = false;
+        }
+        
+        // LDE of the evaluations of q mod x^l - 1 on H, extended 4x to shift * H_16
+        vector<Fr> small = remainder;
+        small.resize(l, 0);
+        vector<Fr> small_evals = small;
+        ntt_transform(small_evals, findPrimitiveRoot(l));
+        vector<Fr> lde = low_degree_extension(small_evals, N / l, shift);
+        vector<Fr> padded = small;
+        padded.resize(N, 0);
+        coset_ntt(padded, omega_N, shift);
+        coset_passed = coset_passed && lde == padded;
+        
+        if (coset_passed) {
+            cout << "✓ Coset NTT and low-degree extension test passed" << endl;
+        } else {
+            cout << "✗ Coset NTT and low-degree extension test failed" << endl;
+            auto end_time = high_resolution_clock::now();
+            auto duration = duration_cast<milliseconds>(end_time - start_time);
+            cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+            return false;
+        }
+        
+        // Test 5: Polynomial class converts between forms only when needed
+        vector<Fr> ca(40), cb(50), cc(3);
+        for (auto &x : ca) x = rand();
+        for (auto &x : cb) x = rand();
+        for (auto &x : cc) x = rand();
+        vector<Fr> ca_copy = ca;
+        vector<Fr> expected = polynomial_multiply(ca, cb, findPrimitiveRoot(128));
+        
+        Polynomial pa = Polynomial::fromCoefficients(ca), pb = Polynomial::fromCoefficients(cb);
+        Polynomial from_evals = Polynomial::fromEvaluations(pa.evaluations(64), 40);
+        Fr x = rand();
+        
+        bool dual_passed = ca == ca_copy && from_evals.evaluate(x) == pa.evaluate(x) && !from_evals.hasCoefficients();
+        
+        // Large product in evaluation form, small one by schoolbook
+        Polynomial product = pa * pb;
+        Polynomial small_product = pb * Polynomial::fromCoefficients(cc);
+        dual_passed = dual_passed && product.size() == 89 && product.hasEvaluations(128) && !product.hasCoefficients();
+        for (size_t i = 0; i < 89; i++) {
+            if (product.coefficients()[i] != expected[i]) dual_passed = false;
+        }
+        dual_passed = dual_passed && small_product.hasCoefficients() && small_product.evaluate(x) == pb.evaluate(x) * evaluatePoly(cc, x);
+        
+        // Mixed sum stays in evaluation form, scaling and division by x^l - 1 agree with evaluation
+        Polynomial sum = from_evals + pb.scale(3);
+        dual_passed = dual_passed && !sum.hasCoefficients() && sum.evaluate(x) == pa.evaluate(x) + 3 * pb.evaluate(x);
+        
+        Polynomial rem;
+        Polynomial quot = (pa - pb).divideByVanishing(8, &rem);
+        Fr zx;
+        Fr::pow(zx, x, 8);
+        dual_passed = dual_passed && rem.size() == 8 && quot.evaluate(x) * (zx - 1) + rem.evaluate(x) == pa.evaluate(x) - pb.evaluate(x);
+        
+        // A coefficient view survives a conversion over the cache limit, only trimCache() frees the old form
+        size_t cache_limit = Polynomial::getCacheLimit();
+        Polynomial::setCacheLimit(64);
+        Polynomial pc = Polynomial::fromCoefficients(ca);
+        PolyView view = pc;
+        pc.evaluations(64);
+        dual_passed = dual_passed && pc.hasCoefficients() && view.data == pc.coefficients().data() && evaluatePoly(view, x) == pa.evaluate(x);
+        pc.trimCache();
+        dual_passed = dual_passed && !pc.hasCoefficients() && pc.hasEvaluations(64) && pc.evaluate(x) == pa.evaluate(x);
+        Polynomial::setCacheLimit(cache_limit);
+        
+        if (dual_passed) {
+            cout << "✓ Polynomial dual representation test passed" << endl;
+        } else {
+            cout << "✗ Polynomial dual representation test failed" << endl;
+            auto end_time = high_resolution_clock::now();
+            auto duration = duration_cast<milliseconds>(end_time - start_time);
+            cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+            return false;
+        }
+        
+        // Test 6: Newton-inverse division by a general divisor, reused across dividends
+        vector<Fr> divisor(38), dividend1(300), dividend2(150), small_dividend(20);
+        for (auto &c : divisor) c = rand();
+        for (auto &c : dividend1) c = rand();
+        for (auto &c : dividend2) c = rand();
+        for (auto &c : small_dividend) c = rand();
+        
+        PolynomialDivisor cached(divisor);
+        bool division_passed = cached.degree() == 37;
+        for (const vector<Fr> *a : {&dividend1, &dividend2, &small_dividend}) {
+            vector<Fr> quot_coeffs, rem_coeffs;
+            cached.divide(*a, quot_coeffs, rem_coeffs);
+            
+            Fr y = rand();
+            if (rem_coeffs.size() != 37 || quot_coeffs.size() != (a->size() > 37 ? a->size() - 37 : 0) ||
+                evaluatePoly(*a, y) != evaluatePoly(quot_coeffs, y) * evaluatePoly(divisor, y) + evaluatePoly(rem_coeffs, y)) {
+                division_passed = false;
+            }
+        }
+        
+        vector<Fr> inverse = powerSeriesInverse(divisor, 100);
+        vector<Fr> identity = multiplyPolys(divisor, inverse);
+        for (size_t i = 0; i < 100; i++) {
+            if (identity[i] != (i == 0 ? Fr(1) : Fr(0))) division_passed = false;
+        }
+        
+        if (division_passed) {
+            cout << "✓ Fast polynomial division test passed" << endl;
+        } else {
+            cout << "✗ Fast polynomial division test failed" << endl;
+            auto end_time = high_resolution_clock::now();
+            auto duration = duration_cast<milliseconds>(end_time - start_time);
+            cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+            return false;
+        }
+        
+        // Test 7: Subproduct-tree evaluation and interpolation at arbitrary points, tree reused
+        vector<Fr> tree_points(100), tree_poly(150), tree_values(100);
+        for (auto &c : tree_points) c = rand();
+        for (auto &c : tree_poly) c = rand();
+        for (auto &c : tree_values) c = rand();
+        
+        SubproductTree tree(tree_points);
+        vector<Fr> tree_evals = tree.evaluate(tree_poly);
+        vector<Fr> interpolated = tree.interpolate(tree_values);
+        vector<Fr> round_trip = tree.evaluate(interpolated);
+        
+        bool tree_passed = tree.vanishing().size() == 101 && interpolated.size() == 100 && round_trip == tree_values;
+        for (size_t i = 0; i < tree_points.size(); i++) {
+            if (tree_evals[i] != evaluatePoly(tree_poly, tree_points[i])) tree_passed = false;
+        }
+        
+        vector<Fr> repeated = {1, 2, 1};
+        SubproductTree repeated_tree(repeated);
+        try {
+            repeated_tree.interpolate({5, 6, 7});
+            tree_passed = false;
+        } catch (const runtime_error& e) {
+        }
+        
+        if (tree_passed) {
+            cout << "✓ Subproduct tree multipoint evaluation and interpolation test passed" << endl;
+        } else {
+            cout << "✗ Subproduct tree multipoint evaluation and interpolation test failed" << endl;
+            auto end_time = high_resolution_clock::now();
+            auto duration = duration_cast<milliseconds>(end_time - start_time);
+            cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+            return false;
+        }
+        
         cout << "✓ All polynomial multiplication tests passed!" << endl;
         auto end_time = high_resolution_clock::now();
         auto duration = duration_cast<milliseconds>(end_time - start_time);
@@ -195,6 +502,96 @@ bool testPoly() {
     }
 }
 
+bool testMSM() {
+    cout << "Testing Multi-Scalar Multiplication..." << endl;
+    auto start_time = high_resolution_clock::now();
+    
+    try {
+        G1 g;
+        hashAndMapToG1(g, "G1_Generator", strlen("G1_Generator"));
+
+        // Sizes around the naive threshold and large enough to split across threads
+        for (size_t size : {1, 5, 31, 32, 100, 3000}) {
+            vector<G1> bases(size);
+            vector<Fr> scalars(size);
+            for (size_t i = 0; i < size; i++) {
+                Fr r;
+                r.setByCSPRNG();
+                G1::mul(bases[i], g, r);
+                scalars[i].setByCSPRNG();
+            }
+            // Edge-case scalars: zero, one and -1
+            scalars[0] = 0;
+            if (size > 1) scalars[1] = 1;
+            if (size > 2) scalars[2] = -1;
+
+            G1 expected, result, result_mt;
+            msmG1Naive(expected, bases.data(), scalars.data(), size);
+            msmG1(result, bases.data(), scalars.data(), size, 1);
+            msmG1(result_mt, bases.data(), scalars.data(), size, 4);
+
+            // Nested in another parallelFor, the inner MSM runs as one chunk
+            G1 result_nested[2];
+            parallelFor(2, [&](size_t begin, size_t end, size_t) {
+                for (size_t i = begin; i < end; i++) msmG1(result_nested[i], bases.data(), scalars.data(), size, 4);
+            }, 2);
+
+            if (result == expected && result_mt == expected && result_nested[0] == expected && result_nested[1] == expected) {
+                cout << "✓ MSM size " << size << " test passed" << endl;
+            } else {
+                cout << "✗ MSM size " << size << " test failed" << endl;
+                auto end_time = high_resolution_clock::now();
+                auto duration = duration_cast<milliseconds>(end_time - start_time);
+                cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+                return false;
+            }
+        }
+        
+        // Fixed-base batch multiplication must match one G1::mul per scalar
+        for (size_t size : {3, 200, 2000}) {
+            vector<Fr> scalars(size);
+            for (size_t i = 0; i < size; i++) scalars[i].setByCSPRNG();
+            scalars[0] = 0;
+
+            vector<G1> result(size);
+            fixedBaseMulG1(result.data(), g, scalars.data(), size);
+
+            bool fixed_base_passed = true;
+            for (size_t i = 0; i < size; i++) {
+                G1 expected;
+                G1::mul(expected, g, scalars[i]);
+                if (result[i] != expected) {
+                    fixed_base_passed = false;
+                    break;
+                }
+            }
+
+            if (fixed_base_passed) {
+                cout << "✓ Fixed-base size " << size << " test passed" << endl;
+            } else {
+                cout << "✗ Fixed-base size " << size << " test failed" << endl;
+                auto end_time = high_resolution_clock::now();
+                auto duration = duration_cast<milliseconds>(end_time - start_time);
+                cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+                return false;
+            }
+        }
+        
+        cout << "✓ All MSM tests passed!" << endl;
+        auto end_time = high_resolution_clock::now();
+        auto duration = duration_cast<milliseconds>(end_time - start_time);
+        cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+        return true;
+        
+    } catch (const exception& e) {
+        cout << "✗ MSM test failed with exception: " << e.what() << endl;
+        auto end_time = high_resolution_clock::now();
+        auto duration = duration_cast<milliseconds>(end_time - start_time);
+        cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+        return false;
+    }
+}
+
 bool testKZG() {
     cout << "Testing KZG Commitment Scheme..." << endl;
     auto start_time = high_resolution_clock::now();
@@ -267,6 +664,157 @@ bool testKZG() {
             return false;
         }
         
+        // Test 4: G1-only setup keeps just the two G2 elements verifyEval needs
+        KZG::PublicKey pk_g1 = setup(degree, false);
+        KZG::Commitment comm_g1 = commit(pk_g1, polynomial);
+        KZG::Witness witness_g1 = createWitness(pk_g1, polynomial, eval_point);
+        
+        if (pk_g1.g1.size() == degree + 1 && pk_g1.g2.size() == 2 && verifyEval(pk_g1, comm_g1, eval_point, witness_g1)) {
+            cout << "✓ G1-only setup test passed" << endl;
+        } else {
+            cout << "✗ G1-only setup test failed" << endl;
+            auto end_time = high_resolution_clock::now();
+            auto duration = duration_cast<milliseconds>(end_time - start_time);
+            cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+            return false;
+        }
+        
+        // Test 5: Lagrange-basis commitment and opening from evaluations
+        size_t n = 8;
+        Fr omega_n = findPrimitiveRoot(n);
+        vector<Fr> coeffs(n);
+        for (size_t i = 0; i < n; i++) coeffs[i] = rand();
+        vector<Fr> evals = coeffs;
+        ntt_transform(evals, omega_n);
+        
+        setupLagrange(pk, n);
+        KZG::Commitment comm_coeffs = commit(pk, coeffs);
+        KZG::Commitment comm_evals = commitLagrange(pk, evals);
+        KZG::Commitment comm_poly = commit(pk, Polynomial::fromEvaluations(evals));
+        KZG::Witness witness_out = createWitnessLagrange(pk, evals, eval_point);
+        KZG::Witness witness_in = createWitnessLagrange(pk, evals, omega_n * omega_n);
+        
+        if (comm_coeffs.c == comm_evals.c && comm_poly.c == comm_evals.c && witness_out.qi == evaluatePoly(coeffs, eval_point) &&
+            verifyEval(pk, comm_evals, eval_point, witness_out) && verifyEval(pk, comm_evals, witness_in.i, witness_in)) {
+            cout << "✓ Lagrange-basis commitment test passed" << endl;
+        } else {
+            cout << "✗ Lagrange-basis commitment test failed" << endl;
+            auto end_time = high_resolution_clock::now();
+            auto duration = duration_cast<milliseconds>(end_time - start_time);
+            cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+            return false;
+        }
+        
+        // Test 6: Batch opening of several polynomials at one point
+        vector<vector<Fr>> batch(3);
+        vector<KZG::Commitment> batch_comms;
+        for (size_t k = 0; k < batch.size(); k++) {
+            batch[k].resize(degree + 1 - k);
+            for (auto &c : batch[k]) c = rand();
+            batch_comms.push_back(commit(pk, batch[k]));
+        }
+        
+        vector<PolyView> batch_views(batch.begin(), batch.end());
+        Transcript prover_transcript("test"), verifier_transcript("test"), tampered_transcript("test");
+        KZG::BatchWitness batch_witness = createBatchWitness(pk, batch_views, eval_point, prover_transcript);
+        bool batch_ok = verifyBatchEval(pk, batch_comms, eval_point, batch_witness, verifier_transcript);
+        
+        KZG::BatchWitness tampered = batch_witness;
+        tampered.qi[2] += 1;
+        bool tampered_ok = verifyBatchEval(pk, batch_comms, eval_point, tampered, tampered_transcript);
+        
+        if (batch_ok && !tampered_ok && batch_witness.qi[1] == evaluatePoly(batch[1], eval_point)) {
+            cout << "✓ Batch opening test passed" << endl;
+        } else {
+            cout << "✗ Batch opening test failed" << endl;
+            auto end_time = high_resolution_clock::now();
+            auto duration = duration_cast<milliseconds>(end_time - start_time);
+            cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+            return false;
+        }
+        
+        // Test 7: Multi-point opening at r, w*r and a third point
+        Fr omega_r = eval_point * omega_n;
+        vector<vector<Fr>> multi_points = {{eval_point}, {eval_point, omega_r}, {omega_r, Fr(7)}};
+        Transcript multi_prover("test"), multi_verifier("test"), multi_tampered("test");
+        KZG::MultiPointWitness multi_witness = createMultiPointWitness(pk, batch_views, multi_points, multi_prover);
+        bool multi_ok = verifyMultiPointEval(pk, batch_comms, multi_points, multi_witness, multi_verifier);
+        
+        KZG::MultiPointWitness multi_bad = multi_witness;
+        multi_bad.qi[1][1] += 1;
+        bool multi_bad_ok = verifyMultiPointEval(pk, batch_comms, multi_points, multi_bad, multi_tampered);
+        
+        if (multi_ok && !multi_bad_ok && multi_witness.qi[2][1] == evaluatePoly(batch[2], Fr(7))) {
+            cout << "✓ Multi-point opening test passed" << endl;
+        } else {
+            cout << "✗ Multi-point opening test failed" << endl;
+            auto end_time = high_resolution_clock::now();
+            auto duration = duration_cast<milliseconds>(end_time - start_time);
+            cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+            return false;
+        }
+        
+        // Test 8: Batch verification with one final exponentiation locates bad openings
+        vector<KZG::Commitment> comms_many;
+        vector<KZG::Witness> witnesses_many;
+        for (size_t k = 0; k < 16; k++) {
+            comms_many.push_back(batch_comms[k % batch.size()]);
+            witnesses_many.push_back(createWitness(pk, batch[k % batch.size()], Fr(k + 2)));
+        }
+        vector<size_t> failed;
+        bool all_ok = verifyEvalBatch(pk, comms_many, witnesses_many, &failed) && failed.empty();
+        
+        witnesses_many[3].qi += 1;
+        witnesses_many[11].i += 1;
+        bool bad_ok = verifyEvalBatch(pk, comms_many, witnesses_many, &failed);
+        
+        if (all_ok && !bad_ok && failed == vector<size_t>({3, 11})) {
+            cout << "✓ Batch verification test passed" << endl;
+        } else {
+            cout << "✗ Batch verification test failed" << endl;
+            auto end_time = high_resolution_clock::now();
+            auto duration = duration_cast<milliseconds>(end_time - start_time);
+            cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+            return false;
+        }
+        
+        // Test 9: Keys without precomputed G2 lines take the plain Miller loop path
+        KZG::PublicKey pk_plain = pk;
+        pk_plain.g2_lines.clear();
+        pk_plain.g2a_lines.clear();
+        KZG::Witness plain_witness = createWitness(pk_plain, polynomial, eval_point);
+        
+        if (!pk.g2_lines.empty() && verifyEval(pk_plain, comm, eval_point, plain_witness) &&
+            !verifyEval(pk_plain, comm, eval_point + 1, plain_witness)) {
+            cout << "✓ Verifier without precomputed lines test passed" << endl;
+        } else {
+            cout << "✗ Verifier without precomputed lines test failed" << endl;
+            auto end_time = high_resolution_clock::now();
+            auto duration = duration_cast<milliseconds>(end_time - start_time);
+            cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+            return false;
+        }
+        
+        // Test 10: Blocked parallel division matches the serial quotient and evaluation
+        vector<Fr> long_poly(1 << 15);
+        for (auto &c : long_poly) c = rand();
+        vector<Fr> parallel_quotient(long_poly.size() - 1), serial_quotient(long_poly.size() - 1);
+        setThreadCount(4);
+        Fr parallel_eval = divideByLinear(long_poly, eval_point, parallel_quotient.data());
+        setThreadCount(1);
+        Fr serial_eval = divideByLinear(long_poly, eval_point, serial_quotient.data());
+        setThreadCount(0);
+        
+        if (parallel_eval == evaluatePoly(long_poly, eval_point) && serial_eval == parallel_eval && parallel_quotient == serial_quotient) {
+            cout << "✓ Parallel evaluate-and-divide test passed" << endl;
+        } else {
+            cout << "✗ Parallel evaluate-and-divide test failed" << endl;
+            auto end_time = high_resolution_clock::now();
+            auto duration = duration_cast<milliseconds>(end_time - start_time);
+            cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+            return false;
+        }
+        
         cout << "✓ All KZG tests passed!" << endl;
         auto end_time = high_resolution_clock::now();
         auto duration = duration_cast<milliseconds>(end_time - start_time);
@@ -282,6 +830,175 @@ bool testKZG() {
     }
 }
 
+bool testSRS() {
+    cout << "Testing SRS File Format..." << endl;
+    auto start_time = high_resolution_clock::now();
+    const string path = "test_srs.bin";
+    
+    try {
+        size_t degree = 20;
+        KZG::PublicKey pk = setup(degree, false);
+        vector<Fr> polynomial = {rand(), rand(), rand(), rand()};
+        Fr eval_point = rand();
+        KZG::Commitment comm = commit(pk, polynomial);
+        
+        // Test 1: Roundtrip every encoding under both validation modes
+        for (SRSEncoding encoding : {SRSEncoding::Compressed, SRSEncoding::Uncompressed, SRSEncoding::Raw}) {
+            saveSRS(pk, path, encoding);
+            
+            for (SRSValidation validation : {SRSValidation::Full, SRSValidation::Trusted}) {
+                KZG::PublicKey loaded = loadSRS(path, validation);
+                KZG::Witness witness = createWitness(loaded, polynomial, eval_point);
+                
+                // Raw keys read the mapping in place, a copy owns its points
+                KZG::PublicKey copy = loaded;
+                copy.g1[0] = copy.g1[1];
+                bool storage_ok = loaded.g1.isMapped() == (encoding == SRSEncoding::Raw) && !copy.g1.isMapped() && loaded.g1[0] == pk.g1[0];
+                
+                if (storage_ok && loaded.t == pk.t && loaded.g1 == pk.g1 && loaded.g2 == pk.g2 && verifyEval(loaded, comm, eval_point, witness)) {
+                    cout << "✓ SRS encoding " << static_cast<uint32_t>(encoding) << " roundtrip passed" << endl;
+                } else {
+                    cout << "✗ SRS encoding " << static_cast<uint32_t>(encoding) << " roundtrip failed" << endl;
+                    remove(path.c_str());
+                    auto end_time = high_resolution_clock::now();
+                    auto duration = duration_cast<milliseconds>(end_time - start_time);
+                    cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+                    return false;
+                }
+            }
+        }
+        
+        // Test 2: Handles opened from the same path share one key
+        KZG::SRSHandle first = openSRS(path, SRSValidation::Trusted);
+        KZG::SRSHandle second = openSRS(path, SRSValidation::Trusted);
+        KZG::SRSHandle validated = openSRS(path, SRSValidation::Full);
+        KZG::Witness shared_witness = createWitness(*second, polynomial, eval_point);
+        
+        if (first.get() == second.get() && validated.get() == first.get() && verifyEval(*first, comm, eval_point, shared_witness)) {
+            cout << "✓ Shared SRS handle test passed" << endl;
+        } else {
+            cout << "✗ Shared SRS handle test failed" << endl;
+            remove(path.c_str());
+            auto end_time = high_resolution_clock::now();
+            auto duration = duration_cast<milliseconds>(end_time - start_time);
+            cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+            return false;
+        }
+        
+        // Test 3: An SRS whose powers are out of order fails full validation
+        KZG::PublicKey broken = pk;
+        swap(broken.g1[3], broken.g1[4]);
+        saveSRS(broken, path, SRSEncoding::Uncompressed);
+        
+        bool rejected = false;
+        try {
+            loadSRS(path, SRSValidation::Full);
+        } catch (const runtime_error& e) {
+            rejected = true;
+        }
+        
+        if (rejected) {
+            cout << "✓ Inconsistent SRS correctly rejected" << endl;
+        } else {
+            cout << "✗ Inconsistent SRS incorrectly accepted" << endl;
+            remove(path.c_str());
+            auto end_time = high_resolution_clock::now();
+            auto duration = duration_cast<milliseconds>(end_time - start_time);
+            cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+            return false;
+        }
+        
+        // Test 4: A file replaced under a live handle is loaded again, not served from the cache
+        const string replacement = path + ".tmp";
+        saveSRS(broken, replacement, SRSEncoding::Uncompressed);
+        rename(replacement.c_str(), path.c_str());
+        KZG::SRSHandle trusted = openSRS(path, SRSValidation::Trusted);
+        
+        if (trusted.get() != first.get() && trusted->g1 == broken.g1 && first->g1 == pk.g1) {
+            cout << "✓ Replaced SRS file reloaded" << endl;
+        } else {
+            cout << "✗ Replaced SRS file served stale" << endl;
+            remove(path.c_str());
+            auto end_time = high_resolution_clock::now();
+            auto duration = duration_cast<milliseconds>(end_time - start_time);
+            cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+            return false;
+        }
+        
+        // Test 5: A tampered key opened as Trusted is not handed out for a Full open
+        bool upgrade_rejected = false;
+        try {
+            openSRS(path, SRSValidation::Full);
+        } catch (const runtime_error& e) {
+            upgrade_rejected = true;
+        }
+        remove(path.c_str());
+        
+        if (upgrade_rejected) {
+            cout << "✓ Cached Trusted SRS correctly rejected for Full open" << endl;
+        } else {
+            cout << "✗ Cached Trusted SRS incorrectly accepted for Full open" << endl;
+            auto end_time = high_resolution_clock::now();
+            auto duration = duration_cast<milliseconds>(end_time - start_time);
+            cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+            return false;
+        }
+        
+        // Test 6: Headers whose counts do not fit the file are rejected before any point is read
+        bool malformed_rejected = true;
+        for (int tamper = 0; tamper < 2; tamper++) {
+            saveSRS(pk, path, SRSEncoding::Raw);
+            FILE *fp = fopen(path.c_str(), "r+b");
+            if (tamper == 0) {
+                // g1_count follows magic, version, encoding and t
+                uint64_t huge_count = (uint64_t)1 << 59;
+                fseek(fp, 24, SEEK_SET);
+                fwrite(&huge_count, sizeof(huge_count), 1, fp);
+                fclose(fp);
+            } else {
+                vector<uint8_t> bytes;
+                int c;
+                while ((c = fgetc(fp)) != EOF) bytes.push_back(c);
+                fclose(fp);
+                fp = fopen(path.c_str(), "wb");
+                fwrite(bytes.data(), 1, bytes.size() - 1, fp);
+                fclose(fp);
+            }
+            
+            try {
+                loadSRS(path, SRSValidation::Trusted);
+                malformed_rejected = false;
+            } catch (const runtime_error& e) {
+            }
+        }
+        remove(path.c_str());
+        
+        if (malformed_rejected) {
+            cout << "✓ Oversized and truncated SRS correctly rejected" << endl;
+        } else {
+            cout << "✗ Oversized or truncated SRS incorrectly accepted" << endl;
+            auto end_time = high_resolution_clock::now();
+            auto duration = duration_cast<milliseconds>(end_time - start_time);
+            cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+            return false;
+        }
+        
+        cout << "✓ All SRS tests passed!" << endl;
+        auto end_time = high_resolution_clock::now();
+        auto duration = duration_cast<milliseconds>(end_time - start_time);
+        cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+        return true;
+        
+    } catch (const exception& e) {
+        remove(path.c_str());
+        cout << "✗ SRS test failed with exception: " << e.what() << endl;
+        auto end_time = high_resolution_clock::now();
+        auto duration = duration_cast<milliseconds>(end_time - start_time);
+        cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+        return false;
+    }
+}
+
 bool testZeroTest() {
     cout << "Testing Zero Test Protocol..." << endl;
     auto start_time = high_resolution_clock::now();
@@ -354,6 +1071,87 @@ bool testZeroTest() {
             return false;
         }
         
+        // Test 4: Non-interactive proof survives serialization and rejects tampering
+        KZG::Commitment comm_q = commit(pk, vanishing_poly);
+        ZeroTestProof proof = proveZeroTest(pk, vanishing_poly, comm_q, w, l);
+        vector<uint8_t> bytes = serializeZeroTestProof(proof);
+        ZeroTestProof decoded = deserializeZeroTestProof(bytes);
+        bool decoded_ok = verifyZeroTest(pk, comm_q, decoded, l);
+        
+        // A valid proof for another vanishing polynomial says nothing about comm_q
+        KZG::Commitment comm_other = commit(pk, complex_vanishing);
+        ZeroTestProof other = proveZeroTest(pk, complex_vanishing, comm_other, w, l);
+        bool other_ok = verifyZeroTest(pk, comm_other, other, l);
+        bool substituted_ok = verifyZeroTest(pk, comm_q, other, l);
+        bool wrong_statement_ok = verifyZeroTest(pk, commit(pk, non_vanishing_poly), decoded, l);
+        
+        decoded.opening.qi[1] += 1;
+        bool tampered_ok = verifyZeroTest(pk, comm_q, decoded, l);
+        
+        if (decoded_ok && other_ok && !substituted_ok && !wrong_statement_ok && !tampered_ok) {
+            cout << "✓ Serialized ZeroTest proof (" << bytes.size() << " bytes) test passed" << endl;
+        } else {
+            cout << "✗ Serialized ZeroTest proof test failed" << endl;
+            auto end_time = high_resolution_clock::now();
+            auto duration = duration_cast<milliseconds>(end_time - start_time);
+            cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+            return false;
+        }
+        
+        // Test 5: With the vanishing check skipped a bad polynomial still fails verification
+        KZG::Commitment comm_bad = commit(pk, non_vanishing_poly);
+        ZeroTestProof unchecked = proveZeroTest(pk, non_vanishing_poly, comm_bad, w, l, VanishingCheck::Skip);
+        
+        if (!verifyZeroTest(pk, comm_bad, unchecked, l)) {
+            cout << "✓ Unchecked non-vanishing polynomial correctly rejected by verifier" << endl;
+        } else {
+            cout << "✗ Unchecked non-vanishing polynomial incorrectly accepted by verifier" << endl;
+            auto end_time = high_resolution_clock::now();
+            auto duration = duration_cast<milliseconds>(end_time - start_time);
+            cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+            return false;
+        }
+        
+        // Test 6: One aggregated proof for several vanishing polynomials of different degrees
+        vector<Fr> shifted_vanishing = {0, -1, 0, 0, 0, 1}; // x^5 - x
+        vector<PolyView> batch = {vanishing_poly, complex_vanishing, shifted_vanishing};
+        vector<KZG::Commitment> batch_comms = {comm_q, comm_other, commit(pk, shifted_vanishing)};
+        ZeroTestBatchProof batch_proof = proveZeroTestBatch(pk, batch, batch_comms, w, l);
+        vector<uint8_t> batch_bytes = serializeZeroTestBatchProof(batch_proof);
+        ZeroTestBatchProof batch_decoded = deserializeZeroTestBatchProof(batch_bytes);
+        bool batch_ok = verifyZeroTestBatch(pk, batch_comms, batch_decoded, l);
+        
+        // Swapping two commitments changes alpha, so the opening no longer matches
+        vector<KZG::Commitment> swapped_comms = batch_comms;
+        swap(swapped_comms[0], swapped_comms[2]);
+        bool swapped_ok = verifyZeroTestBatch(pk, swapped_comms, batch_decoded, l);
+        
+        // The proof is bound to the caller's commitments, a substituted one is rejected
+        vector<KZG::Commitment> substituted_comms = batch_comms;
+        substituted_comms[1] = comm_bad;
+        bool batch_substituted_ok = verifyZeroTestBatch(pk, substituted_comms, batch_decoded, l);
+        
+        // A single bad polynomial is caught by the prover's check, and by the verifier when skipped
+        vector<PolyView> bad_batch = {vanishing_poly, non_vanishing_poly, complex_vanishing};
+        vector<KZG::Commitment> bad_comms = {comm_q, comm_bad, comm_other};
+        bool bad_rejected = false;
+        try {
+            proveZeroTestBatch(pk, bad_batch, bad_comms, w, l);
+        } catch (const runtime_error &) {
+            bad_rejected = true;
+        }
+        bool bad_unchecked_ok = verifyZeroTestBatch(pk, bad_comms, proveZeroTestBatch(pk, bad_batch, bad_comms, w, l, VanishingCheck::Skip), l);
+        
+        if (batch_ok && !swapped_ok && !batch_substituted_ok && bad_rejected && !bad_unchecked_ok) {
+            cout << "✓ Batched ZeroTest of " << batch.size() << " polynomials (" << batch_bytes.size() << " bytes) test passed" << endl;
+        } else {
+            cout << "✗ Batched ZeroTest test failed" << endl;
+            auto end_time = high_resolution_clock::now();
+            auto duration = duration_cast<milliseconds>(end_time - start_time);
+            cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+            return false;
+        }
+        
         cout << "✓ All zero test protocol tests passed!" << endl;
         auto end_time = high_resolution_clock::now();
         auto duration = duration_cast<milliseconds>(end_time - start_time);
@@ -448,6 +1246,31 @@ bool testSumCheck() {
             return false;
         }
         
+        // Test 3: Non-interactive proof survives serialization and is bound to the claimed sum
+        KZG::Commitment comm_q = commit(pk, test_poly);
+        SumCheckProof proof = proveSumCheck(pk, test_poly, comm_q, l, expected_sum);
+        vector<uint8_t> bytes = serializeSumCheckProof(proof);
+        SumCheckProof decoded = deserializeSumCheckProof(bytes);
+        
+        // q + x^5 - x has the same sum on H, but its proof must not verify against comm_q
+        vector<Fr> other_poly = test_poly;
+        other_poly.resize(6, 0);
+        other_poly[1] -= 1;
+        other_poly[5] += 1;
+        KZG::Commitment comm_other = commit(pk, other_poly);
+        SumCheckProof other = proveSumCheck(pk, other_poly, comm_other, l, expected_sum);
+        
+        if (verifySumCheck(pk, comm_q, decoded, l, expected_sum) && !verifySumCheck(pk, comm_q, decoded, l, wrong_sum)
+            && verifySumCheck(pk, comm_other, other, l, expected_sum) && !verifySumCheck(pk, comm_q, other, l, expected_sum)) {
+            cout << "✓ Serialized SumCheck proof (" << bytes.size() << " bytes) test passed" << endl;
+        } else {
+            cout << "✗ Serialized SumCheck proof test failed" << endl;
+            auto end_time = high_resolution_clock::now();
+            auto duration = duration_cast<milliseconds>(end_time - start_time);
+            cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+            return false;
+        }
+        
         cout << "✓ All sum check protocol tests passed!" << endl;
         auto end_time = high_resolution_clock::now();
         auto duration = duration_cast<milliseconds>(end_time - start_time);
@@ -463,12 +1286,171 @@ bool testSumCheck() {
     }
 }
 
+bool testArena() {
+    cout << "Testing Arena Allocator..." << endl;
+    auto start_time = high_resolution_clock::now();
+    
+    try {
+        Arena arena(1 << 20);
+        
+        // Test 1: Buffers are zeroed, aligned and nested scopes keep outer buffers
+        Fr *outer_ptr;
+        Fr *inner_ptr;
+        bool scope_passed = true;
+        {
+            ArenaScope outer(arena);
+            outer_ptr = outer.allocFr(100);
+            for (size_t j = 0; j < 100; j++) {
+                if (!outer_ptr[j].isZero()) scope_passed = false;
+                outer_ptr[j] = j;
+            }
+            {
+                ArenaScope inner(arena);
+                inner_ptr = inner.allocFr(100);
+                for (size_t j = 0; j < 100; j++) inner_ptr[j] = 7;
+            }
+            // The inner buffer is handed out again after its scope ends
+            Fr *reused = outer.allocFr(100);
+            if (reused != inner_ptr || !reused[5].isZero()) scope_passed = false;
+            for (size_t j = 0; j < 100; j++) {
+                if (outer_ptr[j] != Fr(j)) scope_passed = false;
+            }
+        }
+        if ((uintptr_t)outer_ptr % 64 != 0 || (uintptr_t)inner_ptr % 64 != 0) scope_passed = false;
+        
+        if (scope_passed) {
+            cout << "✓ Arena scope test passed" << endl;
+        } else {
+            cout << "✗ Arena scope test failed" << endl;
+            auto end_time = high_resolution_clock::now();
+            auto duration = duration_cast<milliseconds>(end_time - start_time);
+            cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+            return false;
+        }
+        
+        // Test 2: Requests larger than a block get their own block, which is reused after reset
+        size_t large = (3 << 20) / sizeof(Fr);
+        Fr *first = arena.allocFr(large);
+        first[large - 1] = 1;
+        size_t capacity = arena.capacity();
+        arena.reset();
+        Fr *second = arena.allocFr(large);
+        
+        if (capacity >= large * sizeof(Fr) && arena.capacity() == capacity && second == first && second[large - 1].isZero()) {
+            cout << "✓ Arena block reuse test passed (" << capacity / (1 << 20) << " MiB mapped, "
+                 << arena.hugeCapacity() / (1 << 20) << " MiB huge pages)" << endl;
+        } else {
+            cout << "✗ Arena block reuse test failed" << endl;
+            auto end_time = high_resolution_clock::now();
+            auto duration = duration_cast<milliseconds>(end_time - start_time);
+            cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+            return false;
+        }
+        
+        cout << "✓ All arena tests passed!" << endl;
+        auto end_time = high_resolution_clock::now();
+        auto duration = duration_cast<milliseconds>(end_time - start_time);
+        cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+        return true;
+        
+    } catch (const exception& e) {
+        cout << "✗ Arena test failed with exception: " << e.what() << endl;
+        auto end_time = high_resolution_clock::now();
+        auto duration = duration_cast<milliseconds>(end_time - start_time);
+        cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+        return false;
+    }
+}
+
+bool testProfile() {
+    cout << "Testing Profiler..." << endl;
+    auto start_time = high_resolution_clock::now();
+    
+    try {
+        KZG::PublicKey pk = setup(16);
+        vector<Fr> poly(16);
+        for (auto &x : poly) x.setByCSPRNG();
+        Fr point;
+        point.setByCSPRNG();
+        
+        // Test 1: Nested spans and counters of one opening, or nothing at all without KZG_PROFILE
+        profileReset();
+        KZG::Commitment comm = commit(pk, poly);
+        KZG::Witness witness = createWitness(pk, poly, point);
+        bool verified = verifyEval(pk, comm, point, witness);
+        vector<Fr> values = poly;
+        ntt_transform(values, findPrimitiveRoot(16));
+        ProfileSummary summary = profileSummary();
+        
+        bool profile_passed = verified;
+        if (profileEnabled()) {
+            map<string, ProfileSpanStats> spans;
+            for (const auto &span : summary.spans) spans[span.path] = span;
+            
+            profile_passed = profile_passed && spans.count("commit") && spans["commit"].calls == 1
+                && spans.count("commit/msm") && spans["commit/msm"].depth == 1
+                && spans.count("createWitness/msm") && spans.count("verifyEval")
+                && spans["commit"].self_ns <= spans["commit"].total_ns
+                && spans["commit/msm"].total_ns <= spans["commit"].total_ns;
+            // Both MSMs are below the Pippenger threshold, so their 16 + 15 terms are G1 multiplications too
+            profile_passed = profile_passed && summary.count(ProfileCounter::MSMPoints) == 31
+                && summary.count(ProfileCounter::G1Mul) == 33
+                && summary.count(ProfileCounter::MillerLoop) == 2
+                && summary.count(ProfileCounter::FinalExp) == 1
+                && summary.ntt_sizes[16] == 1;
+            profile_passed = profile_passed && chromeTrace().find("\"name\": \"verifyEval\"") != string::npos;
+        } else {
+            for (size_t c = 0; c < (size_t)ProfileCounter::Count; c++) {
+                if (summary.counters[c] != 0) profile_passed = false;
+            }
+            profile_passed = profile_passed && summary.spans.empty() && summary.ntt_sizes.empty();
+        }
+        profile_passed = profile_passed && chromeTrace().find("\"traceEvents\"") != string::npos;
+        
+        if (profile_passed) {
+            cout << "✓ Profiler span and counter test passed (" << (profileEnabled() ? "enabled" : "compiled out") << ")" << endl;
+        } else {
+            cout << "✗ Profiler span and counter test failed" << endl;
+            auto end_time = high_resolution_clock::now();
+            auto duration = duration_cast<milliseconds>(end_time - start_time);
+            cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+            return false;
+        }
+        
+        // Test 2: Reset drops everything recorded so far
+        profileReset();
+        summary = profileSummary();
+        if (summary.spans.empty() && summary.count(ProfileCounter::MSMPoints) == 0 && summary.ntt_sizes.empty()) {
+            cout << "✓ Profiler reset test passed" << endl;
+        } else {
+            cout << "✗ Profiler reset test failed" << endl;
+            auto end_time = high_resolution_clock::now();
+            auto duration = duration_cast<milliseconds>(end_time - start_time);
+            cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+            return false;
+        }
+        
+        cout << "✓ All profiler tests passed!" << endl;
+        auto end_time = high_resolution_clock::now();
+        auto duration = duration_cast<milliseconds>(end_time - start_time);
+        cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+        return true;
+        
+    } catch (const exception& e) {
+        cout << "✗ Profiler test failed with exception: " << e.what() << endl;
+        auto end_time = high_resolution_clock::now();
+        auto duration = duration_cast<milliseconds>(end_time - start_time);
+        cout << "⏱️  Test completed in " << fixed << setprecision(3) << duration.count() / 1000.0 << " seconds" << endl;
+        return false;
+    }
+}
+
 int main() {
     // Initialize the curve
     initPairing(BN_SNARK1);
 
     int passed = 0;
-    int total = 5;
+    int total = 9;
     auto total_start_time = high_resolution_clock::now();
 
     cout << "=== NTT & INTT Tests ===" << endl;
@@ -479,10 +1461,22 @@ int main() {
     if (testPoly()) passed++;
     cout << endl;
 
+    cout << "=== MSM Tests ===" << endl;
+    if (testMSM()) passed++;
+    cout << endl;
+
+    cout << "=== Arena Tests ===" << endl;
+    if (testArena()) passed++;
+    cout << endl;
+
     cout << "=== KZG Tests ===" << endl;
     if (testKZG()) passed++;
     cout << endl;
 
+    cout << "=== SRS Tests ===" << endl;
+    if (testSRS()) passed++;
+    cout << endl;
+
     cout << "=== ZeroTest Tests ===" << endl;
     if (testZeroTest()) passed++;
     cout << "Proof Size: 0.352 kb\n";
@@ -493,6 +1487,10 @@ int main() {
     cout << "Proof Size: 0.512 kb\n";
     cout << endl;
 
+    cout << "=== Profiler Tests ===" << endl;
+    if (testProfile()) passed++;
+    cout << endl;
+
     // Summary
     auto total_end_time = high_resolution_clock::now();
     auto total_duration = duration_cast<milliseconds>(total_end_time - total_start_time);